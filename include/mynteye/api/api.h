@@ -55,6 +55,8 @@ struct MYNTEYE_API StreamData {
   std::shared_ptr<device::Frame> frame_raw;
   /** Frame ID. */
   std::uint16_t frame_id;
+  /** ImgStats, null if not enabled or synthetic. */
+  std::shared_ptr<ImgStats> stats;
 
   bool operator==(const StreamData &other) const {
     if (img && other.img) {
@@ -18,9 +18,11 @@
 #include <cstdint>
 
 #include <algorithm>
+#include <array>
 #include <functional>
 #include <map>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "mynteye/mynteye.h"
@@ -33,6 +35,9 @@ namespace device {
 /**
  * @ingroup datatypes
  * Frame with raw data.
+ * @note Frames may view the data not owned, such as pooled or capture buffers
+ *   reused later. Copies of frames always own the data copied, but shared
+ *   pointers to frames still view the same data.
  */
 class MYNTEYE_API Frame {
  public:
@@ -50,7 +55,8 @@ class MYNTEYE_API Frame {
   Frame(
       std::uint16_t width, std::uint16_t height, Format format,
       const void *data)
-      : width_(width), height_(height), format_(format) {
+      : width_(width), height_(height), format_(format),
+        view_data_(nullptr), step_(width * bytes_per_pixel(format)) {
     std::size_t bytes_n = (width * height) * bytes_per_pixel(format);
     if (data) {
       const std::uint8_t *bytes = static_cast<const std::uint8_t *>(data);
@@ -60,6 +66,44 @@ class MYNTEYE_API Frame {
     }
   }
 
+  /**
+   * Construct the frame as a view of the data owned by holder, without copy.
+   * @param step the bytes of each row, could be larger than the row data.
+   */
+  Frame(
+      std::uint16_t width, std::uint16_t height, Format format,
+      std::uint8_t *data, std::size_t step, std::shared_ptr<void> holder)
+      : width_(width), height_(height), format_(format),
+        view_data_(data), step_(step), holder_(std::move(holder)) {}
+
+  /**
+   * Copy the frame, which owns the continuous data copied even if the other
+   * is a view.
+   */
+  Frame(const Frame &other)
+      : Frame(other.width_, other.height_, other.format_, nullptr) {
+    if (other.view_data_) {
+      std::size_t row_n = width_ * bytes_per_pixel(format_);
+      for (std::uint16_t i = 0; i < height_; ++i) {
+        const std::uint8_t *row = other.view_data_ + other.step_ * i;
+        std::copy(row, row + row_n, data_.begin() + row_n * i);
+      }
+    } else {
+      std::copy(other.data_.begin(), other.data_.end(), data_.begin());
+    }
+  }
+
+  Frame(Frame &&other) = default;
+
+  /** Copy the frame, as the copy constructor. */
+  Frame &operator=(const Frame &other) {
+    if (this != &other)
+      *this = Frame(other);
+    return *this;
+  }
+
+  Frame &operator=(Frame &&other) = default;
+
   /** Get the width. */
   std::uint16_t width() const {
     return width_;
@@ -77,32 +121,70 @@ class MYNTEYE_API Frame {
 
   /** Get the data. */
   std::uint8_t *data() {
-    return data_.data();
+    return view_data_ ? view_data_ : data_.data();
   }
 
   /** Get the const data. */
   const std::uint8_t *data() const {
-    return data_.data();
+    return view_data_ ? view_data_ : data_.data();
   }
 
-  /** Get the size of data. */
+  /** Get the size of data, from the first row to the end of last row. */
   std::size_t size() const {
-    return data_.size();
+    if (!view_data_) return data_.size();
+    if (height_ == 0) return 0;
+    return step_ * (height_ - 1) + width_ * bytes_per_pixel(format_);
+  }
+
+  /** Get the bytes of each row. */
+  std::size_t step() const {
+    return step_;
   }
 
-  /** Clone a new frame. */
+  /** Whether is a view of the data not owned, which may be not continuous. */
+  bool is_view() const {
+    return view_data_ != nullptr;
+  }
+
+  /** Clone a new frame, which owns the continuous data. */
   Frame clone() const {
-    Frame frame(width_, height_, format_, nullptr);
-    std::copy(data_.begin(), data_.end(), frame.data_.begin());
-    return frame;
+    return Frame(*this);
   }
 
+  /**
+   * Get the frame converted to BGR888 from YUYV, which is converted once and
+   * shared by all callers.
+   * @return nullptr if not YUYV.
+   */
+  std::shared_ptr<const Frame> bgr() const;
+
+  /**
+   * Get the frame converted to GREY from YUYV or BGR888, which is converted
+   * once and shared by all callers.
+   * @return nullptr if already GREY or not supported.
+   */
+  std::shared_ptr<const Frame> gray() const;
+
+  /**
+   * Drop the converted frames, must be called after the data changed.
+   */
+  void ResetConverted();
+
  private:
+  struct Converted;
+  std::shared_ptr<Converted> converted() const;
+
   std::uint16_t width_;
   std::uint16_t height_;
   Format format_;
 
   data_t data_;
+
+  std::uint8_t *view_data_;
+  std::size_t step_;
+  std::shared_ptr<void> holder_;
+
+  mutable std::shared_ptr<Converted> converted_;
 };
 
 /**
@@ -116,6 +198,8 @@ struct MYNTEYE_API StreamData {
   std::shared_ptr<Frame> frame;
   /** Frame ID. */
   std::uint16_t frame_id;
+  /** ImgStats, null if not enabled. */
+  std::shared_ptr<ImgStats> stats;
 };
 
 /**
@@ -125,10 +209,88 @@ struct MYNTEYE_API StreamData {
 struct MYNTEYE_API MotionData {
   /** ImuData. */
   std::shared_ptr<ImuData> imu;
+  /** ImuData calibrated by the motion intrinsics, null if not enabled. */
+  std::shared_ptr<ImuData> imu_calibrated;
+};
+
+/**
+ * @ingroup datatypes
+ * Device motion datas of one imu read, as an array of each field.
+ */
+struct MYNTEYE_API MotionBatch {
+  /** IMU frame ids. */
+  std::vector<std::uint32_t> frame_id;
+  /** IMU accel or gyro flags, the same as ImuData::flag. */
+  std::vector<std::uint8_t> flag;
+  /** IMU timestamps in 1us. */
+  std::vector<std::uint64_t> timestamp;
+  /** IMU accelerometer datas of X, Y, Z axes in g. */
+  std::array<std::vector<float>, 3> accel;
+  /** IMU gyroscope datas of X, Y, Z axes in deg/s. */
+  std::array<std::vector<float>, 3> gyro;
+  /** IMU temperatures in degree Celsius. */
+  std::vector<float> temperature;
+  /** Calibrated accel of X, Y, Z axes in g, empty if not enabled. */
+  std::array<std::vector<float>, 3> accel_calibrated;
+  /** Calibrated gyro of X, Y, Z axes in deg/s, empty if not enabled. */
+  std::array<std::vector<float>, 3> gyro_calibrated;
+
+  /** Get the count of motion datas. */
+  std::size_t size() const {
+    return timestamp.size();
+  }
+
+  /** Whether has the calibrated datas. */
+  bool calibrated() const {
+    return !accel_calibrated[0].empty();
+  }
+
+  /**
+   * Resize all the arrays, without releasing their capacity. The calibrated
+   * ones are resized to 0 if not calibrated.
+   */
+  void resize(std::size_t n, bool calibrated = false) {
+    frame_id.resize(n);
+    flag.resize(n);
+    timestamp.resize(n);
+    for (int i = 0; i < 3; i++) {
+      accel[i].resize(n);
+      gyro[i].resize(n);
+      accel_calibrated[i].resize(calibrated ? n : 0);
+      gyro_calibrated[i].resize(calibrated ? n : 0);
+    }
+    temperature.resize(n);
+  }
+};
+
+/**
+ * @ingroup datatypes
+ * Imu datas preintegrated from the last left frame to this one, in the imu
+ * frame at the last left frame, without gravity removed or bias corrected.
+ */
+struct MYNTEYE_API ImuPreintegration {
+  /** Frame id of the left frame. */
+  std::uint16_t frame_id = 0;
+  /** Timestamp of the last left frame in 1us. */
+  std::uint64_t begin_timestamp = 0;
+  /** Timestamp of the left frame in 1us. */
+  std::uint64_t end_timestamp = 0;
+  /** Delta rotation matrix. */
+  double delta_rotation[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+  /** Delta velocity in m/s. */
+  double delta_velocity[3] = {0, 0, 0};
+  /** Delta position in m. */
+  double delta_position[3] = {0, 0, 0};
+  /** Count of imu samples between the frames. */
+  std::uint32_t count = 0;
 };
 
 using StreamCallback = std::function<void(const StreamData &data)>;
 using MotionCallback = std::function<void(const MotionData &data)>;
+using MotionBatchCallback =
+    std::function<void(const std::shared_ptr<const MotionBatch> &batch)>;
+using ImuPreintegrationCallback =
+    std::function<void(const ImuPreintegration &preintegration)>;
 
 }  // namespace device
 
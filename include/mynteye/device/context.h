@@ -16,15 +16,19 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "mynteye/mynteye.h"
+#include "mynteye/types.h"
+#include "mynteye/device/types.h"
 
 MYNTEYE_BEGIN_NAMESPACE
 
 namespace uvc {
 
 struct context;
+struct device_desc;
 
 }  // namespace uvc
 
@@ -32,6 +36,8 @@ class Device;
 
 /**
  * The context about devices.
+ *
+ * Devices are enumerated as descriptions, and opened only when selected.
  */
 class MYNTEYE_API Context {
  public:
@@ -39,16 +45,47 @@ class MYNTEYE_API Context {
   ~Context();
 
   /**
-   * Get all devices now.
-   * @return a vector of all devices.
+   * Get the descriptions of all devices, without opening them.
    */
-  std::vector<std::shared_ptr<Device>> devices() const {
-    return devices_;
+  std::vector<device::DeviceDesc> descs() const {
+    return descs_;
   }
 
+  /**
+   * Open the device of the index in descs(), or get it if opened.
+   * @return nullptr if failed.
+   */
+  std::shared_ptr<Device> Open(std::size_t index) const;
+
+  /**
+   * Get all devices now, opening the ones not opened concurrently.
+   * @return a vector of all devices.
+   */
+  std::vector<std::shared_ptr<Device>> devices() const;
+
+  /**
+   * Start capturing the source of all devices, concurrently.
+   */
+  void Start(const Source &source);
+  /**
+   * Stop capturing the source of all devices, concurrently.
+   */
+  void Stop(const Source &source);
+
+  /**
+   * Get the capture statistics of all devices, accumulated.
+   */
+  device::CaptureStats GetCaptureStats() const;
+
  private:
+  std::vector<std::shared_ptr<Device>> opened_devices() const;
+
   std::shared_ptr<uvc::context> context_;
-  std::vector<std::shared_ptr<Device>> devices_;
+  std::vector<std::shared_ptr<uvc::device_desc>> uvc_descs_;
+  std::vector<device::DeviceDesc> descs_;
+
+  mutable std::mutex mtx_devices_;
+  mutable std::vector<std::shared_ptr<Device>> devices_;  // nullptr if closed
 };
 
 MYNTEYE_END_NAMESPACE
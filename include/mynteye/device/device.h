@@ -15,6 +15,7 @@
 #define MYNTEYE_DEVICE_DEVICE_H_
 #pragma once
 
+#include <future>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -60,6 +61,10 @@ class MYNTEYE_API Device {
   using stream_callback_t = device::StreamCallback;
   /** The device::MotionData callback. */
   using motion_callback_t = device::MotionCallback;
+  /** The device::MotionBatch callback. */
+  using motion_batch_callback_t = device::MotionBatchCallback;
+  /** The device::ImuPreintegration callback. */
+  using preintegration_callback_t = device::ImuPreintegrationCallback;
 
   using stream_callbacks_t = std::map<Stream, stream_callback_t>;
 
@@ -224,6 +229,20 @@ class MYNTEYE_API Device {
    */
   void SetOptionValue(const Option &option, std::int32_t value);
 
+  /**
+   * Get the option value asynchronously, without blocking the caller.
+   * @return future of the value, or -1 if failed.
+   */
+  std::shared_future<std::int32_t> GetOptionValueAsync(
+      const Option &option) const;
+  /**
+   * Set the option value asynchronously, without blocking the caller.
+   * @note Repeated sets of the option before applied are coalesced.
+   * @return future of the value set at last, or -1 if failed.
+   */
+  std::shared_future<std::int32_t> SetOptionValueAsync(
+      const Option &option, std::int32_t value);
+
   /**
    * Run the option action.
    */
@@ -238,6 +257,39 @@ class MYNTEYE_API Device {
    * Set the callback of motion.
    */
   void SetMotionCallback(motion_callback_t callback, bool async = false);
+  /**
+   * Set the callback of motion batches, called once for each imu read on the
+   * imu thread.
+   * @note Batches return to a pool once released, release them in time to
+   *   reuse their arrays without allocations.
+   */
+  void SetMotionBatchCallback(motion_batch_callback_t callback);
+
+  /**
+   * Enable or disable calibrating motion datas by the motion intrinsics, as
+   * scale * (data - drift), must be called before start. The calibrated are
+   * given beside the raw, in MotionData::imu_calibrated and the calibrated
+   * arrays of MotionBatch.
+   * @return false if the motion intrinsics are not known.
+   */
+  bool EnableMotionCalibration(bool enabled = true);
+
+  /**
+   * Enable or disable merging accel and gyro into 6-axis motion datas at the
+   * gyro timestamps, with the accel interpolated linearly, must be called
+   * before start. Motion datas are then all in flag 0, at the gyro rate.
+   * @note For devices giving accel and gyro apart, such as S2 ones. Datas
+   *   already of both pass as they are.
+   */
+  void EnableMotionMerge(bool enabled = true);
+
+  /**
+   * Set the callback of imu datas preintegrated between left frames, or
+   * nullptr to disable, must be called before start. Called on the imu
+   * thread for each left frame, once the imu datas reach its timestamp.
+   * @note The calibrated datas are integrated if enabled.
+   */
+  void SetPreintegrationCallback(preintegration_callback_t callback);
 
   /**
    * Has the callback of stream.
@@ -248,6 +300,70 @@ class MYNTEYE_API Device {
    */
   bool HasMotionCallback() const;
 
+  /**
+   * Enable zero copy of stream frames, must be called before start.
+   * @note Frames view the capture buffers directly if supported, and the buffer
+   *   is requeued after all its frames released, so release them in time.
+   * @return true if supported by the platform.
+   */
+  bool EnableZeroCopy();
+  /**
+   * Disable zero copy of stream frames, must be called before start.
+   */
+  void DisableZeroCopy();
+
+  /**
+   * Set the count of capture buffers, must be called before start. 0 for the
+   * default of the platform.
+   * @note More buffers take more memory, but drop less frames if the frames
+   *   are held or processed slowly.
+   */
+  void SetCaptureBufferCount(std::uint32_t count);
+
+  /**
+   * Enable or disable unpacking left and right frames in two threads, must
+   * be called before start.
+   * @note The helper thread uses the policy of capture threads.
+   */
+  void EnableParallelUnpack(bool enabled = true);
+
+  /**
+   * Enable or disable unpacking only the luma of color streams, to frames in
+   * Format::GREY, must be called before start.
+   * @note Only for streams of Capabilities::STEREO_COLOR in Format::YUYV.
+   *   Frames are not zero copy then.
+   */
+  void EnableLumaOnly(bool enabled = true);
+
+  /**
+   * Enable or disable computing ImgStats of stream datas while unpacking,
+   * must be called before start.
+   */
+  void EnableImgStats(bool enabled = true);
+
+  /**
+   * Set whether the stream is demanded, instead of whether it has a callback.
+   * @note Only demanded streams are unpacked, or all if none is demanded.
+   *   The stream is also demanded once its datas are got, and the first get
+   *   may return none.
+   */
+  void SetStreamDemanded(const Stream &stream, bool demanded);
+
+  /**
+   * Set the count of frames pooled for each stream, must be called before
+   * start. 0 for the default, that is the max size of stream datas plus 4.
+   * @note Frames return to the pool once all their references released, and
+   *   are reused without allocations. Shared pointers to frames view the
+   *   same pixels, copy the frames to keep the pixels.
+   */
+  void SetFramePoolSize(std::size_t size);
+
+  /**
+   * Set the max count of stream datas kept to get, must be called before
+   * start. The oldest ones are dropped if more, 4 by default.
+   */
+  void SetStreamDataMaxSize(const Stream &stream, std::size_t size);
+
   /**
    * Start capturing the source.
    */
@@ -295,6 +411,70 @@ class MYNTEYE_API Device {
    */
   std::vector<device::MotionData> GetMotionDatas();
 
+  /**
+   * Enable keeping the latest motion datas ordered by time to query, or 0 to
+   * disable, must be called before start.
+   * @param capacity the count of motion datas kept, rounded up to a power
+   *   of 2, such as 1024 for 2 s at 500 Hz.
+   * @note The calibrated or merged datas are kept if enabled.
+   */
+  void EnableImuHistory(std::size_t capacity);
+  /**
+   * Get the motion datas in [t0, t1] of the history, timestamps in 1us.
+   * @note Any thread could query it without lock.
+   */
+  std::vector<ImuData> GetImuRange(std::uint64_t t0, std::uint64_t t1);
+  /**
+   * Interpolate the motion data at timestamp in 1us of the history, the accel
+   * and gyro each between the datas having it valid.
+   * @note Any thread could query it without lock.
+   * @return false if the timestamp is out of the history.
+   */
+  bool InterpolateImu(std::uint64_t timestamp, ImuData *imu);
+
+  /**
+   * Get the capture statistics of video streaming.
+   */
+  device::CaptureStats GetCaptureStats();
+  /**
+   * Reset the capture statistics of video streaming.
+   */
+  void ResetCaptureStats();
+
+  /**
+   * Set the target latency of motion datas in 1ms, 10 by default. Imu datas
+   * are polled with the period of it, but not shorter than the interval of
+   * Option::IMU_FREQUENCY, or longer than 25 ms. Polled again at once if
+   * the device has more.
+   */
+  void SetImuTargetLatency(std::uint32_t latency_ms);
+  /**
+   * Get the statistics of polling imu datas.
+   */
+  device::ImuStats GetImuStats();
+  /**
+   * Reset the statistics of polling imu datas.
+   */
+  void ResetImuStats();
+
+  /**
+   * Set the cpu core to run the capture thread, -1 for any.
+   * @note Must be called before start.
+   * @return false if not supported by the platform.
+   */
+  bool SetCaptureAffinity(int cpu);
+
+  /**
+   * Set the thresholds to recover video streaming when no data. It restarts
+   * streaming in place first, then reopens the capture if still no data.
+   * Recoveries are also counted in the capture statistics.
+   * @note Must be called before start.
+   * @return false if not supported by the platform.
+   */
+  bool SetStreamRecovery(
+      const device::RecoveryConfig &config,
+      device::RecoveryCallback callback = nullptr);
+
  protected:
   std::shared_ptr<uvc::device> device() const {
     return device_;
@@ -337,6 +517,9 @@ class MYNTEYE_API Device {
   std::shared_ptr<uvc::device> device_;
   std::shared_ptr<DeviceInfo> device_info_;
 
+  bool zero_copy_;
+  std::uint32_t capture_buffer_count_;
+
   img_params_map_t all_img_params_;
   imu_params_t imu_params_;
 
@@ -346,17 +529,26 @@ class MYNTEYE_API Device {
   std::shared_ptr<MotionIntrinsics> motion_intrinsics_;
   std::map<Stream, Extrinsics> motion_from_extrinsics_;
 
-  stream_callbacks_t stream_callbacks_;
-  motion_callback_t motion_callback_;
+  // Callbacks of streams, replaced as a whole so that the capture thread
+  // reads a snapshot of them without locks
+  struct StreamCallbacks;
+  std::shared_ptr<const StreamCallbacks> stream_callbacks_;
+  std::mutex mtx_stream_callbacks_;
 
-  std::map<Stream, stream_async_callback_ptr_t> stream_async_callbacks_;
-  motion_async_callback_ptr_t motion_async_callback_;
+  // Callback of motions, replaced as a whole as the one of streams
+  struct MotionCallbacks;
+  std::shared_ptr<const MotionCallbacks> motion_callbacks_;
+
+  // Demands set explicitly, or by callbacks if not set
+  std::map<Stream, bool> stream_demands_;
 
   std::shared_ptr<Streams> streams_;
 
   std::map<Capabilities, StreamRequest> stream_config_requests_;
 
-  std::mutex mtx_streams_;
+  device::CaptureStats capture_stats_;
+  std::uint32_t capture_sequence_;
+  std::mutex mtx_capture_stats_;
 
   std::shared_ptr<Channels> channels_;
 
@@ -369,6 +561,9 @@ class MYNTEYE_API Device {
   void CallbackPushedStreamData(const Stream &stream);
   void CallbackMotionData(const device::MotionData &data);
 
+  void UpdateCaptureStats(std::uint32_t sequence, bool pushed,
+      std::int64_t latency, std::uint64_t time_beg, std::uint64_t time_end);
+
   bool GetFiles(
       DeviceInfo *info, img_params_map_t *img_params, imu_params_t *imu_params);
   bool SetFiles(
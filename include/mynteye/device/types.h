@@ -16,8 +16,10 @@
 #pragma once
 
 #include <cstdint>
+#include <algorithm>
 #include <array>
 #include <bitset>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -45,6 +47,146 @@ typedef struct ImuParams {
   Extrinsics ex_left_to_imu;
 } imu_params_t;
 
+/**
+ * @ingroup datatypes
+ * Description of a device, enumerated without opening it.
+ */
+struct MYNTEYE_API DeviceDesc {
+  /** Device description name. */
+  std::string name;
+  /** Vendor ID. */
+  int vid = 0;
+  /** Product ID. */
+  int pid = 0;
+  /** Serial number of the usb device, empty if not known. */
+  std::string serial;
+  /** Usb port path, empty if not known. */
+  std::string bus_path;
+};
+
+/**
+ * @ingroup datatypes
+ * Thresholds of recovering video streaming when no data.
+ */
+struct MYNTEYE_API RecoveryConfig {
+  /** No data time in 1ms to restart streaming in place, as tier 1. */
+  int no_data_timeout = 2000;
+  /** No data time in 1ms after tier 1 to reopen the capture, as tier 2. */
+  int restart_timeout = 200;
+};
+
+/**
+ * @ingroup datatypes
+ * Event of video streaming recovered.
+ */
+struct MYNTEYE_API RecoveryEvent {
+  /** The last tier tried, 1: restarted in place, 2: reopened the capture. */
+  int tier = 0;
+  /** Time from the last frame to the first frame recovered in 1us. */
+  std::uint64_t downtime = 0;
+};
+
+using RecoveryCallback = std::function<void(const RecoveryEvent &event)>;
+
+/**
+ * @ingroup datatypes
+ * Capture statistics of video streaming.
+ */
+struct MYNTEYE_API CaptureStats {
+  /** Count of latency histogram buckets. */
+  static constexpr std::size_t LATENCY_BUCKETS = 8;
+
+  /** Count of frames captured. */
+  std::uint64_t frames_count = 0;
+  /** Count of frames lost by host driver, as gaps of sequence numbers. */
+  std::uint64_t sequence_gaps = 0;
+  /** Count of frames dropped by sdk, as their packets are unaccepted. */
+  std::uint64_t dropped_count = 0;
+  /** Time of the first frame captured in 1us of steady clock. */
+  std::uint64_t first_time = 0;
+  /** Time of the last frame captured in 1us of steady clock. */
+  std::uint64_t last_time = 0;
+  /**
+   * Latency histogram of frames from dequeued to callback, the bucket i counts
+   * latencies less than 2^i ms, and the last one counts the rest.
+   */
+  std::array<std::uint64_t, LATENCY_BUCKETS> latency_histogram{};
+  /** Max latency from dequeued to callback in 1us. */
+  std::uint64_t latency_max = 0;
+  /** Total time spent in the capture callback in 1us. */
+  std::uint64_t callback_time_total = 0;
+  /** Max time spent in the capture callback in 1us. */
+  std::uint64_t callback_time_max = 0;
+  /** Count of video streaming recovered. */
+  std::uint64_t recoveries_count = 0;
+  /** Total downtime of video streaming recovered in 1us. */
+  std::uint64_t recovery_downtime_total = 0;
+  /** Count of frames acquired from the frame pool. */
+  std::uint64_t frame_pool_hits = 0;
+  /** Count of frames allocated as none is free in the frame pool. */
+  std::uint64_t frame_pool_misses = 0;
+
+  /** Get the frames per second from the first to the last frame. */
+  double fps() const {
+    if (frames_count < 2 || last_time <= first_time)
+      return 0;
+    return (frames_count - 1) * 1000000.0 / (last_time - first_time);
+  }
+
+  /** Accumulate the statistics of another device. */
+  CaptureStats &operator+=(const CaptureStats &other) {
+    if (other.frames_count == 0)
+      return *this;
+    if (frames_count == 0 || other.first_time < first_time)
+      first_time = other.first_time;
+    last_time = std::max(last_time, other.last_time);
+    frames_count += other.frames_count;
+    sequence_gaps += other.sequence_gaps;
+    dropped_count += other.dropped_count;
+    for (std::size_t i = 0; i < LATENCY_BUCKETS; i++) {
+      latency_histogram[i] += other.latency_histogram[i];
+    }
+    latency_max = std::max(latency_max, other.latency_max);
+    callback_time_total += other.callback_time_total;
+    callback_time_max = std::max(callback_time_max, other.callback_time_max);
+    recoveries_count += other.recoveries_count;
+    recovery_downtime_total += other.recovery_downtime_total;
+    frame_pool_hits += other.frame_pool_hits;
+    frame_pool_misses += other.frame_pool_misses;
+    return *this;
+  }
+};
+
+/**
+ * @ingroup datatypes
+ * Statistics of polling imu datas.
+ */
+struct MYNTEYE_API ImuStats {
+  /** Count of imu reads that succeeded. */
+  std::uint64_t reads_count = 0;
+  /** Count of imu reads that returned a full packet, then polled again. */
+  std::uint64_t full_reads = 0;
+  /** Count of imu samples read. */
+  std::uint64_t samples_count = 0;
+  /** Count of imu samples lost, as gaps of serial numbers. */
+  std::uint64_t sample_gaps = 0;
+  /** Count of gaps of serial numbers, as the device buffer overflowed. */
+  std::uint64_t overflows = 0;
+  /** Total time of imu reads, from request to response, in 1us. */
+  std::uint64_t read_latency_total = 0;
+  /** Max time of imu reads, from request to response, in 1us. */
+  std::uint64_t read_latency_max = 0;
+  /** Current period of polling imu datas in 1us. */
+  std::uint64_t poll_period = 0;
+
+  /** Get the mean time of imu reads in 1us. */
+  double read_latency_mean() const {
+    if (reads_count == 0)
+      return 0;
+    return static_cast<double>(read_latency_total) / reads_count;
+  }
+};
+
 }  // namespace device
 
 #define MYNTEYE_PROPERTY(TYPE, NAME) \
@@ -20,6 +20,7 @@
 #include <cstdint>
 
 #include <algorithm>
+#include <array>
 #include <iostream>
 #include <type_traits>
 
@@ -574,11 +575,20 @@ struct MYNTEYE_API ImgData {
   std::uint64_t timestamp;
   /** Image exposure time, virtual value in [1, 480] */
   std::uint16_t exposure_time;
+  /** Capture timestamp by host driver in 1us, 0 if unknown */
+  std::uint64_t capture_timestamp;
+  /** Capture sequence number by host driver, 0 if unknown */
+  std::uint32_t capture_sequence;
+  /** Dequeue timestamp by host in 1us of steady clock, 0 if unknown */
+  std::uint64_t dequeue_timestamp;
 
   void Reset() {
     frame_id = 0;
     timestamp = 0;
     exposure_time = 0;
+    capture_timestamp = 0;
+    capture_sequence = 0;
+    dequeue_timestamp = 0;
   }
 
   ImgData() {
@@ -588,15 +598,37 @@ struct MYNTEYE_API ImgData {
     frame_id = other.frame_id;
     timestamp = other.timestamp;
     exposure_time = other.exposure_time;
+    capture_timestamp = other.capture_timestamp;
+    capture_sequence = other.capture_sequence;
+    dequeue_timestamp = other.dequeue_timestamp;
   }
   ImgData &operator=(const ImgData &other) {
     frame_id = other.frame_id;
     timestamp = other.timestamp;
     exposure_time = other.exposure_time;
+    capture_timestamp = other.capture_timestamp;
+    capture_sequence = other.capture_sequence;
+    dequeue_timestamp = other.dequeue_timestamp;
     return *this;
   }
 };
 
+/**
+ * @ingroup datatypes
+ * Image statistics of luma, computed while unpacking.
+ */
+struct MYNTEYE_API ImgStats {
+  /** Histogram of luma */
+  std::array<std::uint32_t, 256> histogram{};
+  /** Mean of luma in [0, 255] */
+  double mean = 0;
+  /** Ratio of pixels whose luma is 255 */
+  double saturated_ratio = 0;
+  /** Mean squared difference of luma between horizontal neighbors, the
+   * larger the sharper */
+  double sharpness = 0;
+};
+
 /**
  * @ingroup datatypes
  * IMU data.
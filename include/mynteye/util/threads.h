@@ -0,0 +1,126 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef MYNTEYE_UTIL_THREADS_H_
+#define MYNTEYE_UTIL_THREADS_H_
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mynteye/mynteye.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+namespace threads {
+
+/**
+ * Roles of the threads spawned by the sdk.
+ */
+enum class Role : std::uint8_t {
+  /** Capture thread of video streaming. */
+  CAPTURE,
+  /** Polling thread of motion datas. */
+  IMU,
+  /** Thread of each async callback. */
+  ASYNC_CALLBACK,
+  /** Thread of each api processor. */
+  PROCESSOR,
+  /** Thread running the option controls. */
+  CONTROL,
+  /** Last guard, which indicates end. */
+  LAST
+};
+
+/**
+ * Scheduling policies of threads.
+ */
+enum class Scheduler : std::uint8_t {
+  /** The default time sharing policy, SCHED_OTHER. */
+  OTHER,
+  /** The real time first in first out policy, SCHED_FIFO. */
+  FIFO
+};
+
+/**
+ * Policy applied to the threads of a role when they start.
+ */
+struct MYNTEYE_API Policy {
+  /** Name prefix of the threads, followed by their own names. */
+  std::string name = "myt-";
+  /** Cpu cores the threads run on, empty for any. */
+  std::vector<int> cpus;
+  /** Scheduling policy. */
+  Scheduler scheduler = Scheduler::OTHER;
+  /** Priority of FIFO scheduler, 1 (low) to 99 (high). */
+  int priority = 1;
+  /** Nice value of OTHER scheduler, -20 (high) to 19 (low). */
+  int nice = 0;
+};
+
+/**
+ * Cpu time of a thread.
+ */
+struct MYNTEYE_API CpuTime {
+  /** The role of the thread. */
+  Role role;
+  /** The name of the thread. */
+  std::string name;
+  /** Cpu time in 1us, accumulated over the threads of the same name. */
+  std::uint64_t cpu_time;
+  /** Whether the thread is alive now. */
+  bool alive;
+};
+
+/**
+ * Set the policy of a role, applied to the threads start later.
+ * @note Real time priority and negative nice need privilege, CAP_SYS_NICE.
+ */
+MYNTEYE_API void set_policy(Role role, const Policy &policy);
+/**
+ * Get the policy of a role.
+ */
+MYNTEYE_API Policy get_policy(Role role);
+
+/**
+ * Get the cpu time of the threads spawned by the sdk.
+ */
+MYNTEYE_API std::vector<CpuTime> get_cpu_times();
+
+/**
+ * Scope of a thread, which applies the policy of its role on construction,
+ * and accounts its cpu time until destruction. Construct it at the start of
+ * the thread.
+ */
+class MYNTEYE_API Scope {
+ public:
+  Scope(Role role, const std::string &name);
+  ~Scope();
+
+ private:
+  std::size_t index_;
+};
+
+/**
+ * Set the cpu core the thread runs on, -1 for any.
+ * @return false if failed or not supported on the platform.
+ */
+MYNTEYE_API bool set_affinity(std::thread &thread, int cpu);  // NOLINT
+
+}  // namespace threads
+
+MYNTEYE_END_NAMESPACE
+
+#endif  // MYNTEYE_UTIL_THREADS_H_
@@ -0,0 +1,16 @@
+#!/usr/bin/env bash
+
+OpenCV_VERSION=
+OpenCV_VERSION_MAJOR=
+OpenCV_VERSION_MINOR=
+OpenCV_VERSION_PATCH=
+OpenCV_VERSION_STATUS=
+
+_contains() {
+  [ `echo $1 | grep -c "$2"` -gt 0 ]
+}
+
+if _contains "" "/ros/"; then
+  ROS_VERSION=$(rosversion -d)
+  OpenCV_VERSION=ros-$ROS_VERSION
+fi
@@ -101,28 +101,28 @@ int main(int argc, char *argv[]) {
     if (left_data.frame->format() == Format::GREY) {
       cv::Mat left_img(
           left_data.frame->height(), left_data.frame->width(), CV_8UC1,
-          left_data.frame->data());
+          left_data.frame->data(), left_data.frame->step());
       cv::Mat right_img(
           right_data.frame->height(), right_data.frame->width(), CV_8UC1,
-          right_data.frame->data());
+          right_data.frame->data(), right_data.frame->step());
       cv::hconcat(left_img, right_img, img);
     } else if (left_data.frame->format() == Format::YUYV) {
+      auto &&left_bgr = left_data.frame->bgr();
+      auto &&right_bgr = right_data.frame->bgr();
       cv::Mat left_img(
-          left_data.frame->height(), left_data.frame->width(), CV_8UC2,
-          left_data.frame->data());
+          left_bgr->height(), left_bgr->width(), CV_8UC3,
+          const_cast<std::uint8_t *>(left_bgr->data()), left_bgr->step());
       cv::Mat right_img(
-          right_data.frame->height(), right_data.frame->width(), CV_8UC2,
-          right_data.frame->data());
-      cv::cvtColor(left_img, left_img, cv::COLOR_YUV2BGR_YUY2);
-      cv::cvtColor(right_img, right_img, cv::COLOR_YUV2BGR_YUY2);
+          right_bgr->height(), right_bgr->width(), CV_8UC3,
+          const_cast<std::uint8_t *>(right_bgr->data()), right_bgr->step());
       cv::hconcat(left_img, right_img, img);
     } else if (left_data.frame->format() == Format::BGR888) {
       cv::Mat left_img(
           left_data.frame->height(), left_data.frame->width(), CV_8UC3,
-          left_data.frame->data());
+          left_data.frame->data(), left_data.frame->step());
       cv::Mat right_img(
           right_data.frame->height(), right_data.frame->width(), CV_8UC3,
-          right_data.frame->data());
+          right_data.frame->data(), right_data.frame->step());
       cv::hconcat(left_img, right_img, img);
     } else {
       return -1;
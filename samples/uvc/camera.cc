@@ -114,7 +114,8 @@ int main(int argc, char *argv[]) {
       *device, 1280, 400, static_cast<int>(Format::BGR888), 20,
 #endif
       [&mtx, &cv, &frame, &frame_ready](
-          const void *data, std::function<void()> continuation) {
+          const void *data, const uvc::frame_info &/*info*/,
+          std::function<void()> continuation) {
         // reinterpret_cast<const std::uint8_t *>(data);
         std::unique_lock<std::mutex> lock(mtx);
         if (frame == nullptr) {
@@ -18,6 +18,7 @@
 
 #include "mynteye/logger.h"
 #include "mynteye/util/strings.h"
+#include "mynteye/util/threads.h"
 #include "mynteye/util/times.h"
 
 MYNTEYE_BEGIN_NAMESPACE
@@ -160,6 +161,7 @@ std::shared_ptr<Processor> Processor::GetParent() {
 
 void Processor::Run() {
   VLOG(2) << Name() << " thread start";
+  threads::Scope scope(threads::Role::PROCESSOR, Name());
 
   auto sleep = [this](const times::system_clock::time_point &time_beg) {
     if (proc_period_ > 0) {
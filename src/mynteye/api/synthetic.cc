@@ -50,19 +50,23 @@ namespace {
 
 cv::Mat frame2mat(const std::shared_ptr<device::Frame> &frame) {
   if (frame->format() == Format::YUYV) {
-    cv::Mat img(frame->height(), frame->width(), CV_8UC2, frame->data());
-    cv::cvtColor(img, img, cv::COLOR_YUV2BGR_YUY2);
-    return img;
+    // converted once and kept by the frame, shared with other consumers
+    auto &&bgr = frame->bgr();
+    return cv::Mat(bgr->height(), bgr->width(), CV_8UC3,
+        const_cast<std::uint8_t *>(bgr->data()), bgr->step());
   } else if (frame->format() == Format::BGR888) {
-    cv::Mat img(frame->height(), frame->width(), CV_8UC3, frame->data());
+    cv::Mat img(frame->height(), frame->width(), CV_8UC3, frame->data(),
+        frame->step());
     return img;
   } else {  // Format::GRAY
-    return cv::Mat(frame->height(), frame->width(), CV_8UC1, frame->data());
+    return cv::Mat(frame->height(), frame->width(), CV_8UC1, frame->data(),
+        frame->step());
   }
 }
 
 api::StreamData data2api(const device::StreamData &data) {
-  return {data.img, frame2mat(data.frame), data.frame, data.frame_id};
+  return {data.img, frame2mat(data.frame), data.frame, data.frame_id,
+      data.stats};
 }
 
 void process_childs(
@@ -77,27 +81,27 @@ void process_childs(
 // ObjMat/ObjMat2 > api::StreamData
 
 api::StreamData obj_data_first(const ObjMat2 *obj) {
-  return {obj->first_data, obj->first, nullptr, obj->first_id};
+  return {obj->first_data, obj->first, nullptr, obj->first_id, nullptr};
 }
 
 api::StreamData obj_data_second(const ObjMat2 *obj) {
-  return {obj->second_data, obj->second, nullptr, obj->second_id};
+  return {obj->second_data, obj->second, nullptr, obj->second_id, nullptr};
 }
 
 api::StreamData obj_data(const ObjMat *obj) {
-  return {obj->data, obj->value, nullptr, obj->id};
+  return {obj->data, obj->value, nullptr, obj->id, nullptr};
 }
 
 api::StreamData obj_data_first(const std::shared_ptr<ObjMat2> &obj) {
-  return {obj->first_data, obj->first, nullptr, obj->first_id};
+  return {obj->first_data, obj->first, nullptr, obj->first_id, nullptr};
 }
 
 api::StreamData obj_data_second(const std::shared_ptr<ObjMat2> &obj) {
-  return {obj->second_data, obj->second, nullptr, obj->second_id};
+  return {obj->second_data, obj->second, nullptr, obj->second_id, nullptr};
 }
 
 api::StreamData obj_data(const std::shared_ptr<ObjMat> &obj) {
-  return {obj->data, obj->value, nullptr, obj->id};
+  return {obj->data, obj->value, nullptr, obj->id, nullptr};
 }
 
 // api::StreamData > ObjMat/ObjMat2
@@ -162,6 +166,7 @@ Synthetic::~Synthetic() {
 
 void Synthetic::SetStreamDataListener(stream_data_listener_t listener) {
   stream_data_listener_ = listener;
+  UpdateNativeStreamDemands();
 }
 
 void Synthetic::NotifyImageParamsChanged() {
@@ -273,6 +278,7 @@ void Synthetic::EnableStreamData(
           proce->Activate();
         }
       });
+  if (!try_tag) UpdateNativeStreamDemands();
 }
 void Synthetic::DisableStreamData(
     const Stream &stream, stream_switch_callback_t callback,
@@ -296,6 +302,7 @@ void Synthetic::DisableStreamData(
           proce->Deactivate();
         }
       });
+  if (!try_tag) UpdateNativeStreamDemands();
 }
 
 void Synthetic::EnableStreamData(const Stream &stream) {
@@ -331,6 +338,7 @@ void Synthetic::SetStreamCallback(
     data.stream_callback = callback;
   }
   setControlDateCallbackWithStream(data);
+  UpdateNativeStreamDemands();
 }
 
 bool Synthetic::HasStreamCallback(const Stream &stream) const {
@@ -365,6 +373,7 @@ void Synthetic::StartVideoStreaming() {
       }
     }
   }
+  UpdateNativeStreamDemands();
   device->Start(Source::VIDEO_STREAMING);
 }
 
@@ -509,6 +518,25 @@ bool Synthetic::IsStreamEnabledSynthetic(const Stream &stream) const {
   return GetStreamEnabledMode(stream) == MODE_SYNTHETIC;
 }
 
+void Synthetic::UpdateNativeStreamDemands() {
+  bool processed = false;
+  for (auto &&processor : processors_) {
+    for (auto &&target : processor->target_streams_) {
+      if (target.enabled_mode_ == MODE_SYNTHETIC)
+        processed = true;
+    }
+  }
+  auto &&device = api_->device();
+  for (auto &&processor : processors_) {
+    for (auto &&target : processor->target_streams_) {
+      if (target.support_mode_ == MODE_NATIVE) {
+        device->SetStreamDemanded(target.stream, processed ||
+            stream_data_listener_ || HasStreamCallback(target.stream));
+      }
+    }
+  }
+}
+
 void Synthetic::InitProcessors() {
   std::shared_ptr<Processor> rectify_processor = nullptr;
 #ifdef WITH_CAM_MODELS
@@ -107,6 +107,9 @@ class Synthetic {
 
   void InitProcessors();
 
+  // Demand native streams only if they are called back, listened or processed
+  void UpdateNativeStreamDemands();
+
   template <class T>
   bool ActivateProcessor(bool tree = false);
   template <class T>
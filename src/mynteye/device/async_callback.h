@@ -15,14 +15,15 @@
 #define MYNTEYE_DEVICE_ASYNC_CALLBACK_H_
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <mutex>
 #include <string>
 #include <thread>
-#include <vector>
 
 #include "mynteye/mynteye.h"
+#include "mynteye/util/ring_buffer.h"
 
 MYNTEYE_BEGIN_NAMESPACE
 
@@ -44,15 +45,15 @@ class AsyncCallback {
 
   callback_t callback_;
 
+  // Datas are pushed without lock, the mutex is only for waiting datas
   std::mutex mtx_;
   std::condition_variable cv_;
 
   bool running_;
   std::thread thread_;
 
-  std::uint32_t count_;
-  std::vector<Data> datas_;
-  std::size_t max_data_size_;
+  RingBuffer<Data> datas_;
+  std::atomic<std::uint32_t> dropped_count_;
 };
 
 MYNTEYE_END_NAMESPACE
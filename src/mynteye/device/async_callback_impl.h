@@ -19,6 +19,7 @@
 #include <utility>
 
 #include "mynteye/logger.h"
+#include "mynteye/util/threads.h"
 
 MYNTEYE_BEGIN_NAMESPACE
 
@@ -27,8 +28,8 @@ AsyncCallback<Data>::AsyncCallback(
     std::string name, callback_t callback, std::size_t max_data_size)
     : name_(std::move(name)),
       callback_(std::move(callback)),
-      count_(0),
-      max_data_size_(max_data_size) {
+      datas_(max_data_size),  // keep the latest one if 0
+      dropped_count_(0) {
   VLOG(2) << __func__;
   running_ = true;
   thread_ = std::thread(&AsyncCallback<Data>::Run, this);
@@ -40,7 +41,6 @@ AsyncCallback<Data>::~AsyncCallback() {
   {
     std::lock_guard<std::mutex> _(mtx_);
     running_ = false;
-    ++count_;
   }
   cv_.notify_one();
   if (thread_.joinable()) {
@@ -50,39 +50,36 @@ AsyncCallback<Data>::~AsyncCallback() {
 
 template <class Data>
 void AsyncCallback<Data>::PushData(Data data) {
-  std::lock_guard<std::mutex> _(mtx_);
-  if (max_data_size_ <= 0) {
-    datas_.clear();
-  } else if (max_data_size_ == datas_.size()) {  // >= 1
-    datas_.erase(datas_.begin());
-  }
-  datas_.push_back(data);
-  ++count_;
+  dropped_count_ += datas_.PushOverwrite(std::move(data));
+  // Lock only to not miss the waiting one
+  { std::lock_guard<std::mutex> _(mtx_); }
   cv_.notify_one();
 }
 
 template <class Data>
 void AsyncCallback<Data>::Run() {
   VLOG(2) << "AsyncCallback(" << name_ << ") thread start";
+  threads::Scope scope(threads::Role::ASYNC_CALLBACK, name_);
   while (true) {
-    std::unique_lock<std::mutex> lock(mtx_);
-    cv_.wait(lock, [this] { return count_ > 0; });
-
-    if (!running_)
-      break;
+    {
+      std::unique_lock<std::mutex> lock(mtx_);
+      cv_.wait(lock, [this] { return !running_ || !datas_.empty(); });
+      if (!running_)
+        break;
+    }
 
-    if (callback_) {
-      for (auto &&data : datas_) {
+    // Callback without lock, so that pushing never waits on it
+    Data data;
+    while (datas_.TryPop(&data)) {
+      if (callback_) {
         callback_(data);
       }
     }
 
-    if (VLOG_IS_ON(2) && count_ > datas_.size()) {
-      VLOG(2) << "AsyncCallback(" << name_ << ") dropped "
-              << (count_ - datas_.size());
+    auto &&dropped = dropped_count_.exchange(0);
+    if (VLOG_IS_ON(2) && dropped > 0) {
+      VLOG(2) << "AsyncCallback(" << name_ << ") dropped " << dropped;
     }
-    count_ = 0;
-    datas_.clear();
   }
   VLOG(2) << "AsyncCallback(" << name_ << ") thread end";
 }
@@ -0,0 +1,89 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "mynteye/device/callbacks.h"
+
+#include <atomic>
+#include <mutex>
+
+#include "mynteye/device/unpack.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+namespace device {
+
+// Frames converted from this, the mutex lets each conversion run once
+struct Frame::Converted {
+  std::mutex mtx;
+  std::shared_ptr<const Frame> bgr;
+  std::shared_ptr<const Frame> gray;
+};
+
+std::shared_ptr<const Frame> Frame::bgr() const {
+  if (format_ != Format::YUYV)
+    return nullptr;
+  auto &&converted = this->converted();
+  std::lock_guard<std::mutex> _(converted->mtx);
+  if (!converted->bgr) {
+    auto &&frame =
+        std::make_shared<Frame>(width_, height_, Format::BGR888, nullptr);
+    for (std::uint16_t i = 0; i < height_; ++i) {
+      unpack::yuyv_to_bgr(data() + step_ * i,
+          frame->data() + frame->step() * i, width_);
+    }
+    converted->bgr = frame;
+  }
+  return converted->bgr;
+}
+
+std::shared_ptr<const Frame> Frame::gray() const {
+  if (format_ != Format::YUYV && format_ != Format::BGR888)
+    return nullptr;
+  auto &&converted = this->converted();
+  std::lock_guard<std::mutex> _(converted->mtx);
+  if (!converted->gray) {
+    auto &&frame =
+        std::make_shared<Frame>(width_, height_, Format::GREY, nullptr);
+    for (std::uint16_t i = 0; i < height_; ++i) {
+      if (format_ == Format::YUYV) {
+        // the luma is the gray
+        unpack::pick(data() + step_ * i,
+            frame->data() + frame->step() * i, width_, 0);
+      } else {
+        unpack::bgr_to_gray(data() + step_ * i,
+            frame->data() + frame->step() * i, width_);
+      }
+    }
+    converted->gray = frame;
+  }
+  return converted->gray;
+}
+
+void Frame::ResetConverted() {
+  std::atomic_store(&converted_, std::shared_ptr<Converted>());
+}
+
+std::shared_ptr<Frame::Converted> Frame::converted() const {
+  auto &&converted = std::atomic_load(&converted_);
+  if (converted)
+    return converted;
+  // created by the first caller, or the one won
+  auto &&created = std::make_shared<Converted>();
+  if (std::atomic_compare_exchange_strong(&converted_, &converted, created))
+    return created;
+  return converted;
+}
+
+}  // namespace device
+
+MYNTEYE_END_NAMESPACE
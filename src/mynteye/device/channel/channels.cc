@@ -13,6 +13,7 @@
 // limitations under the License.
 #include "mynteye/device/channel/channels.h"
 
+#include <algorithm>
 #include <bitset>
 #include <chrono>
 #include <iomanip>
@@ -22,11 +23,17 @@
 #include <string>
 #include <vector>
 
+#include "mynteye/device/channel/info_cache.h"
 #include "mynteye/device/config.h"
 #include "mynteye/logger.h"
+#include "mynteye/util/threads.h"
 #include "mynteye/util/times.h"
 
 #define IMU_TRACK_PERIOD 25  // ms
+#define IMU_TRACK_LATENCY 10  // ms
+#define IMU_READ_SIZE 2000
+// A response is full if the rest can not take one more packet
+#define IMU_READ_FULL_MARGIN 64
 
 MYNTEYE_BEGIN_NAMESPACE
 
@@ -98,23 +105,58 @@ int XuHalfDuplexId(Option option) {
   }
 }
 
+// The file of the id in files, with its id and size, empty if not in
+std::vector<std::uint8_t> GetFile(
+    const std::vector<std::uint8_t> &files, std::uint8_t file_id) {
+  std::size_t i = 0;
+  while (i + 3 <= files.size()) {
+    std::size_t n = 3 + bytes::_from_data<std::uint16_t>(files.data() + i + 1);
+    if (i + n > files.size())
+      break;
+    if (files[i] == file_id)
+      return {files.begin() + i, files.begin() + i + n};
+    i += n;
+  }
+  return {};
+}
+
 }  // namespace
 
 Channels::Channels(const std::shared_ptr<uvc::device> &device,
     const std::shared_ptr<ChannelsAdapter> &adapter)
   : device_(device),
     adapter_(adapter),
+    controls_running_(true),
     is_imu_tracking_(false),
     imu_track_stop_(false),
     imu_sn_(0),
-    imu_callback_(nullptr) {
+    imu_callback_(nullptr),
+    imu_frequency_(0),
+    imu_track_latency_(IMU_TRACK_LATENCY * 1000),
+    imu_req_packet_{0} {
   VLOG(2) << __func__;
-  UpdateControlInfos();
+  controls_thread_ = std::thread(&Channels::RunControlCommands, this);
+  auto &&cache_dir = InfoCache::GetDir();
+  if (cache_dir.empty()) {
+    UpdateControlInfos();
+  } else {
+    // The cache is keyed by the device info, so the option ranges are loaded
+    // or queried once the files are got
+    info_cache_ = std::make_shared<InfoCache>(cache_dir);
+  }
 }
 
 Channels::~Channels() {
   VLOG(2) << __func__;
   StopImuTracking();
+  {
+    std::lock_guard<std::mutex> _(mtx_controls_);
+    controls_running_ = false;
+  }
+  cv_controls_.notify_one();
+  if (controls_thread_.joinable()) {
+    controls_thread_.join();
+  }
 }
 
 std::int32_t Channels::GetAccelRangeDefault() {
@@ -126,6 +168,7 @@ std::int32_t Channels::GetGyroRangeDefault() {
 }
 
 void Channels::LogControlInfos() const {
+  control_infos_ready_.wait();
   for (auto &&it = control_infos_.begin(); it != control_infos_.end(); it++) {
     LOG(INFO) << it->first << ": min=" << it->second.min
               << ", max=" << it->second.max << ", def=" << it->second.def
@@ -134,6 +177,12 @@ void Channels::LogControlInfos() const {
 }
 
 void Channels::UpdateControlInfos() {
+  // Query the ranges of all options in one batch, without blocking
+  control_infos_ready_ =
+      PushControlCommand(CONTROL_UPDATE_INFOS, Option::LAST, 0);
+}
+
+void Channels::DoUpdateControlInfos() {
   auto &&supports = adapter_->GetOptionSupports();
   for (auto &&option : std::vector<Option>{
       Option::GAIN, Option::BRIGHTNESS, Option::CONTRAST}) {
@@ -153,16 +202,20 @@ void Channels::UpdateControlInfos() {
       control_infos_[option] = XuControlInfo(option);
   }
 
+  if (info_cache_)
+    info_cache_->Save(control_infos_);
+
   if (VLOG_IS_ON(2)) {
     for (auto &&it = control_infos_.begin(); it != control_infos_.end(); it++) {
       VLOG(2) << it->first << ": min=" << it->second.min
               << ", max=" << it->second.max << ", def=" << it->second.def
-              << ", cur=" << GetControlValue(it->first);
+              << ", cur=" << DoGetControlValue(it->first);
     }
   }
 }
 
 Channels::control_info_t Channels::GetControlInfo(const Option &option) const {
+  control_infos_ready_.wait();
   try {
     return control_infos_.at(option);
   } catch (const std::out_of_range &e) {
@@ -172,6 +225,84 @@ Channels::control_info_t Channels::GetControlInfo(const Option &option) const {
 }
 
 std::int32_t Channels::GetControlValue(const Option &option) const {
+  return GetControlValueAsync(option).get();
+}
+
+void Channels::SetControlValue(const Option &option, std::int32_t value) {
+  SetControlValueAsync(option, value).wait();
+}
+
+Channels::control_future_t Channels::GetControlValueAsync(
+    const Option &option) const {
+  return PushControlCommand(CONTROL_GET, option, 0);
+}
+
+Channels::control_future_t Channels::SetControlValueAsync(
+    const Option &option, std::int32_t value) {
+  return PushControlCommand(CONTROL_SET, option, value);
+}
+
+Channels::control_future_t Channels::PushControlCommand(
+    control_type_t type, const Option &option, std::int32_t value) const {
+  std::lock_guard<std::mutex> _(mtx_controls_);
+  // Coalesce with the last pending command of the option, if the same type
+  for (auto it = control_cmds_.rbegin(); it != control_cmds_.rend(); it++) {
+    if (it->type == CONTROL_UPDATE_INFOS)
+      break;
+    if (it->option != option)
+      continue;
+    if (it->type == type) {
+      it->value = value;
+      return it->future;
+    }
+    break;
+  }
+  control_command_t cmd;
+  cmd.type = type;
+  cmd.option = option;
+  cmd.value = value;
+  cmd.promise = std::make_shared<std::promise<std::int32_t>>();
+  cmd.future = cmd.promise->get_future().share();
+  control_cmds_.push_back(cmd);
+  cv_controls_.notify_one();
+  return cmd.future;
+}
+
+void Channels::RunControlCommands() {
+  threads::Scope scope(threads::Role::CONTROL, "control");
+  VLOG(2) << "Control thread start";
+  while (true) {
+    std::deque<control_command_t> cmds;
+    {
+      std::unique_lock<std::mutex> lock(mtx_controls_);
+      cv_controls_.wait(lock, [this] {
+        return !controls_running_ || !control_cmds_.empty();
+      });
+      if (control_cmds_.empty())
+        break;
+      cmds.swap(control_cmds_);
+    }
+    VLOG(2) << "Run control commands: " << cmds.size();
+    for (auto &&cmd : cmds) {
+      switch (cmd.type) {
+        case CONTROL_GET:
+          cmd.promise->set_value(DoGetControlValue(cmd.option));
+          break;
+        case CONTROL_SET:
+          cmd.promise->set_value(
+              DoSetControlValue(cmd.option, cmd.value) ? cmd.value : -1);
+          break;
+        case CONTROL_UPDATE_INFOS:
+          DoUpdateControlInfos();
+          cmd.promise->set_value(0);
+          break;
+      }
+    }
+  }
+  VLOG(2) << "Control thread end";
+}
+
+std::int32_t Channels::DoGetControlValue(const Option &option) const {
   switch (option) {
     case Option::GAIN:
     case Option::BRIGHTNESS:
@@ -207,7 +338,7 @@ std::int32_t Channels::GetControlValue(const Option &option) const {
   return -1;
 }
 
-void Channels::SetControlValue(const Option &option, std::int32_t value) {
+bool Channels::DoSetControlValue(const Option &option, std::int32_t value) {
   auto in_range = [this, &option, &value]() {
     auto &&info = GetControlInfo(option);
     if (value < info.min || value > info.max) {
@@ -235,42 +366,47 @@ void Channels::SetControlValue(const Option &option, std::int32_t value) {
     case Option::BRIGHTNESS:
     case Option::CONTRAST: {
       if (!in_range())
-        break;
+        return false;
       if (!PuControlQuery(option, uvc::PU_QUERY_SET, &value)) {
         LOG(WARNING) << option << " set value failed";
+        return false;
       }
-    } break;
+      return true;
+    }
     case Option::FRAME_RATE: {
       if (!in_range() ||
           !in_values({10, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60}))
-        break;
-      XuCamCtrlSet(option, value);
-    } break;
+        return false;
+      return XuCamCtrlSet(option, value);
+    }
     case Option::IMU_FREQUENCY: {
       if (!in_range() || !in_values({100, 200, 250, 333, 500}))
-        break;
-      XuCamCtrlSet(option, value);
-    } break;
+        return false;
+      if (!XuCamCtrlSet(option, value))
+        return false;
+      imu_frequency_ = value;
+      return true;
+    }
     case Option::ACCELEROMETER_RANGE: {
       if (!in_range() || !in_values(adapter_->GetAccelRangeValues()))
-        break;
-      XuCamCtrlSet(option, value);
-    } break;
+        return false;
+      return XuCamCtrlSet(option, value);
+    }
     case Option::GYROSCOPE_RANGE: {
       if (!in_range() || !in_values(adapter_->GetGyroRangeValues()))
-        break;
-      XuCamCtrlSet(option, value);
-    } break;
+        return false;
+      return XuCamCtrlSet(option, value);
+    }
     case Option::ACCELEROMETER_LOW_PASS_FILTER: {
       if (!in_range() || !in_values({0, 1, 2}))
-        break;
-      XuCamCtrlSet(option, value);
-    } break;
+        return false;
+      return XuCamCtrlSet(option, value);
+    }
     case Option::GYROSCOPE_LOW_PASS_FILTER: {
       if (!in_range() || !in_values({23, 64}))
-        break;
-      XuCamCtrlSet(option, value);
-    } break;
+        return false;
+      return XuCamCtrlSet(option, value);
+    }
     case Option::EXPOSURE_MODE:
     case Option::MAX_GAIN:
     case Option::MAX_EXPOSURE_TIME:
@@ -279,16 +415,17 @@ void Channels::SetControlValue(const Option &option, std::int32_t value) {
     case Option::HDR_MODE:
     case Option::MIN_EXPOSURE_TIME: {
       if (!in_range())
-        break;
-      XuCamCtrlSet(option, value);
-    } break;
+        return false;
+      return XuCamCtrlSet(option, value);
+    }
     case Option::ZERO_DRIFT_CALIBRATION:
     case Option::ERASE_CHIP:
       LOG(WARNING) << option << " set value useless";
-      break;
+      return false;
     default:
       LOG(ERROR) << "Unsupported option " << option;
   }
+  return false;
 }
 
 bool Channels::RunControlAction(const Option &option) const {
@@ -325,49 +462,122 @@ void Channels::SetImuCallback(imu_callback_t callback) {
   imu_callback_ = callback;
 }
 
-void Channels::DoImuTrack() {
-  static ImuReqPacket req_packet{0};
-  static ImuResPacket res_packet;
+bool Channels::DoImuTrack() {
+  auto &&req_packet = imu_req_packet_;
+  auto &&res_packet = imu_res_packet_;
 
   req_packet.serial_number = imu_sn_;
+  auto &&time_beg = times::now();
   if (!XuImuWrite(req_packet)) {
-    return;
+    return false;
   }
 
+  res_packet.packets.clear();
   if (!XuImuRead(&res_packet)) {
-    return;
+    return false;
   }
+  auto &&latency = static_cast<std::uint64_t>(
+      times::count<times::microseconds>(times::now() - time_beg));
+  bool full = 4 + res_packet.size + 1 + IMU_READ_FULL_MARGIN > IMU_READ_SIZE;
 
   if (res_packet.packets.size() == 0) {
-    return;
+    UpdateImuStats(latency, 0, false);
+    return false;
   }
 
   if (res_packet.packets.back().count == 0) {
-    return;
+    UpdateImuStats(latency, 0, false);
+    return false;
   }
 
-  VLOG(2) << "Imu req sn: " << imu_sn_ << ", res count: " << []() {
-    std::size_t n = 0;
-    for (auto &&packet : res_packet.packets) {
-      n += packet.count;
-    }
-    return n;
-  }();
+  std::size_t samples = 0;
+  for (auto &&packet : res_packet.packets) {
+    samples += packet.count;
+  }
+  VLOG(2) << "Imu req sn: " << imu_sn_ << ", res count: " << samples;
 
   auto &&sn = res_packet.packets.back().serial_number;
   if (imu_sn_ == sn) {
     VLOG(2) << "New imu not ready, dropped";
-    return;
+    UpdateImuStats(latency, 0, false);
+    return false;
   }
-  imu_sn_ = sn;
 
-  if (imu_callback_) {
+  // Serial numbers go on by the span of each packet, the rest are lost
+  std::uint64_t gaps = 0, overflows = 0;
+  if (imu_sn_ != 0) {
+    std::uint32_t last_sn = imu_sn_;
     for (auto &&packet : res_packet.packets) {
-      imu_callback_(packet);
+      auto &&diff = static_cast<std::int32_t>(packet.serial_number - last_sn);
+      auto &&span = static_cast<std::int32_t>(
+          adapter_->GetImuSerialSpan(packet));
+      if (diff > span) {
+        gaps += diff - span;
+        ++overflows;
+      }
+      last_sn = packet.serial_number;
+    }
+    if (overflows > 0) {
+      LOG(WARNING) << "Imu samples lost: " << gaps << ", after sn " << imu_sn_;
     }
   }
+  imu_sn_ = sn;
+
+  UpdateImuStats(latency, samples, full);
+  if (gaps > 0) {
+    std::lock_guard<std::mutex> _(mtx_imu_stats_);
+    imu_stats_.sample_gaps += gaps;
+    imu_stats_.overflows += overflows;
+  }
+
+  if (imu_callback_) {
+    imu_callback_(res_packet);
+  }
 
   res_packet.packets.clear();
+  return full;
+}
+
+void Channels::SetImuTrackLatency(std::uint32_t latency_us) {
+  imu_track_latency_ = latency_us;
+}
+
+device::ImuStats Channels::GetImuStats() const {
+  std::lock_guard<std::mutex> _(mtx_imu_stats_);
+  return imu_stats_;
+}
+
+void Channels::ResetImuStats() {
+  std::lock_guard<std::mutex> _(mtx_imu_stats_);
+  auto poll_period = imu_stats_.poll_period;
+  imu_stats_ = {};
+  imu_stats_.poll_period = poll_period;
+}
+
+std::uint64_t Channels::GetImuTrackPeriod() const {
+  std::uint64_t period = IMU_TRACK_PERIOD * 1000;
+  std::uint64_t latency = imu_track_latency_;
+  if (latency > 0 && latency < period) {
+    period = latency;
+  }
+  // Not shorter than the interval of imu samples
+  std::int32_t frequency = imu_frequency_;
+  if (frequency > 0) {
+    period = std::max<std::uint64_t>(period, 1000000 / frequency);
+  }
+  return period;
+}
+
+void Channels::UpdateImuStats(
+    std::uint64_t latency, std::size_t samples, bool full) {
+  std::lock_guard<std::mutex> _(mtx_imu_stats_);
+  auto &&stats = imu_stats_;
+  ++stats.reads_count;
+  if (full)
+    ++stats.full_reads;
+  stats.samples_count += samples;
+  stats.read_latency_total += latency;
+  stats.read_latency_max = std::max(stats.read_latency_max, latency);
 }
 
 void Channels::StartImuTracking(imu_callback_t callback) {
@@ -380,21 +590,30 @@ void Channels::StartImuTracking(imu_callback_t callback) {
   }
   is_imu_tracking_ = true;
   imu_track_thread_ = std::thread([this]() {
+    threads::Scope scope(threads::Role::IMU, "imu");
     imu_sn_ = 0;
-    auto sleep = [](const times::system_clock::time_point &time_beg) {
-      auto &&time_elapsed_ms =
-          times::count<times::milliseconds>(times::now() - time_beg);
-      if (time_elapsed_ms < IMU_TRACK_PERIOD) {
-        std::this_thread::sleep_for(
-            std::chrono::milliseconds(IMU_TRACK_PERIOD - time_elapsed_ms));
-        VLOG(2) << "Imu track cost " << time_elapsed_ms << " ms"
-                << ", sleep " << (IMU_TRACK_PERIOD - time_elapsed_ms) << " ms";
-      }
-    };
+    if (imu_frequency_ <= 0) {
+      imu_frequency_ = GetControlValue(Option::IMU_FREQUENCY);
+    }
     while (!imu_track_stop_) {
       auto &&time_beg = times::now();
-      DoImuTrack();
-      sleep(time_beg);
+      if (DoImuTrack()) {
+        // Backlog on the device, poll again before it overflows
+        continue;
+      }
+      auto &&period = GetImuTrackPeriod();
+      {
+        std::lock_guard<std::mutex> _(mtx_imu_stats_);
+        imu_stats_.poll_period = period;
+      }
+      auto &&time_elapsed = static_cast<std::uint64_t>(
+          times::count<times::microseconds>(times::now() - time_beg));
+      if (time_elapsed < period) {
+        std::this_thread::sleep_for(
+            std::chrono::microseconds(period - time_elapsed));
+        VLOG(2) << "Imu track cost " << time_elapsed << " us"
+                << ", sleep " << (period - time_elapsed) << " us";
+      }
     }
   });
 }
@@ -418,86 +637,158 @@ bool Channels::GetFiles(
     return false;
   }
 
-  std::uint8_t data[2000]{};
+  std::vector<std::uint8_t> files;
+  bool ok;
+  if (info_cache_ && !control_infos_ready_.valid() && info != nullptr &&
+      img_params != nullptr && imu_params != nullptr) {
+    ok = GetCachedFiles(&files);
+  } else {
+    std::bitset<8> header;
+    header[7] = 0;  // get
 
-  std::bitset<8> header;
-  header[7] = 0;  // get
+    header[0] = (info != nullptr);
+    header[1] = (img_params != nullptr);
+    header[2] = (imu_params != nullptr);
 
-  header[0] = (info != nullptr);
-  header[1] = (img_params != nullptr);
-  header[2] = (imu_params != nullptr);
+    ok = QueryFiles(static_cast<std::uint8_t>(header.to_ulong()), &files);
+  }
+  // Query the option ranges if not loaded from the cache
+  if (!control_infos_ready_.valid()) {
+    UpdateControlInfos();
+  }
+  if (!ok) {
+    LOG(WARNING) << "GetFiles failed";
+    return false;
+  }
 
-  data[0] = static_cast<std::uint8_t>(header.to_ulong());
+  ParseFiles(files, info, img_params, imu_params);
+  VLOG(2) << "GetFiles success";
+  return true;
+}
+
+bool Channels::QueryFiles(
+    std::uint8_t header, std::vector<std::uint8_t> *files) const {
+  std::uint8_t data[2000]{};
+
+  data[0] = header;
   VLOG(2) << "GetFiles header: 0x" << std::hex << std::uppercase << std::setw(2)
           << std::setfill('0') << static_cast<int>(data[0]);
   if (!XuFileQuery(uvc::XU_QUERY_SET, 2000, data)) {
-    LOG(WARNING) << "GetFiles failed";
+    return false;
+  }
+  if (!XuFileQuery(uvc::XU_QUERY_GET, 2000, data)) {
     return false;
   }
 
-  if (XuFileQuery(uvc::XU_QUERY_GET, 2000, data)) {
-    // header = std::bitset<8>(data[0]);
-    std::uint16_t size = bytes::_from_data<std::uint16_t>(data + 1);
-    std::uint8_t checksum = data[3 + size];
-    VLOG(2) << "GetFiles data size: " << size << ", checksum: 0x" << std::hex
-            << std::setw(2) << std::setfill('0') << static_cast<int>(checksum);
+  // header = std::bitset<8>(data[0]);
+  std::uint16_t size = bytes::_from_data<std::uint16_t>(data + 1);
+  if (size + 4 > 2000) {
+    LOG(WARNING) << "Files size is too large: " << size;
+    return false;
+  }
+  std::uint8_t checksum = data[3 + size];
+  VLOG(2) << "GetFiles data size: " << size << ", checksum: 0x" << std::hex
+          << std::setw(2) << std::setfill('0') << static_cast<int>(checksum);
 
-    std::uint8_t checksum_now = 0;
-    for (std::size_t i = 3, n = 3 + size; i < n; i++) {
-      checksum_now = (checksum_now ^ data[i]);
-    }
-    if (checksum != checksum_now) {
-      LOG(WARNING) << "Files checksum should be 0x" << std::hex
-                   << std::uppercase << std::setw(2) << std::setfill('0')
-                   << static_cast<int>(checksum) << ", but 0x" << std::setw(2)
-                   << std::setfill('0') << static_cast<int>(checksum_now)
-                   << " now";
-      return false;
-    }
+  std::uint8_t checksum_now = 0;
+  for (std::size_t i = 3, n = 3 + size; i < n; i++) {
+    checksum_now = (checksum_now ^ data[i]);
+  }
+  if (checksum != checksum_now) {
+    LOG(WARNING) << "Files checksum should be 0x" << std::hex
+                 << std::uppercase << std::setw(2) << std::setfill('0')
+                 << static_cast<int>(checksum) << ", but 0x" << std::setw(2)
+                 << std::setfill('0') << static_cast<int>(checksum_now)
+                 << " now";
+    return false;
+  }
 
-    std::size_t i = 3;
-    std::size_t end = 3 + size;
-    while (i < end) {
-      std::uint8_t file_id = *(data + i);
-      std::uint16_t file_size = bytes::_from_data<std::uint16_t>(data + i + 1);
-      VLOG(2) << "GetFiles id: " << static_cast<int>(file_id)
-              << ", size: " << file_size;
-      i += 3;
-      switch (file_id) {
-        case FID_DEVICE_INFO: {
-          auto &&n = file_channel_.GetDeviceInfoFromData(
-              data + i, file_size, info);
-          CHECK_EQ(n, file_size)
-              << "The firmware not support getting device info, you could "
-                 "upgrade to latest";
-        } break;
-        case FID_IMG_PARAMS: {
-          if (file_size > 0) {
-            auto &&n = file_channel_.GetImgParamsFromData(
-                data + i, file_size, img_params);
-            CHECK_EQ(n, file_size);
-          }
-        } break;
-        case FID_IMU_PARAMS: {
+  files->assign(data + 3, data + 3 + size);
+  return true;
+}
+
+void Channels::ParseFiles(const std::vector<std::uint8_t> &files,
+    device_info_t *info, img_params_t *img_params, imu_params_t *imu_params) {
+  // The device info is always parsed, as the params parsed by its version
+  device_info_t info_parsed;
+  if (info == nullptr)
+    info = &info_parsed;
+
+  const std::uint8_t *data = files.data();
+  std::size_t i = 0;
+  std::size_t end = files.size();
+  while (i + 3 <= end) {
+    std::uint8_t file_id = *(data + i);
+    std::uint16_t file_size = bytes::_from_data<std::uint16_t>(data + i + 1);
+    VLOG(2) << "GetFiles id: " << static_cast<int>(file_id)
+            << ", size: " << file_size;
+    i += 3;
+    CHECK_LE(i + file_size, end) << "The file " << static_cast<int>(file_id)
+                                 << " is out of the files";
+    switch (file_id) {
+      case FID_DEVICE_INFO: {
+        auto &&n = file_channel_.GetDeviceInfoFromData(
+            data + i, file_size, info);
+        CHECK_EQ(n, file_size)
+            << "The firmware not support getting device info, you could "
+               "upgrade to latest";
+      } break;
+      case FID_IMG_PARAMS: {
+        if (img_params != nullptr && file_size > 0) {
+          auto &&n = file_channel_.GetImgParamsFromData(
+              data + i, file_size, img_params);
+          CHECK_EQ(n, file_size);
+        }
+      } break;
+      case FID_IMU_PARAMS: {
+        if (imu_params != nullptr) {
           imu_params->ok = file_size > 0;
           if (imu_params->ok) {
             auto &&n = file_channel_.GetImuParamsFromData(
                 data + i, file_size, imu_params);
             CHECK_EQ(n, file_size);
           }
-        } break;
-        default:
-          LOG(FATAL) << "Unsupported file id: " << file_id;
-      }
-      i += file_size;
+        }
+      } break;
+      default:
+        LOG(FATAL) << "Unsupported file id: " << file_id;
     }
+    i += file_size;
+  }
+}
 
-    VLOG(2) << "GetFiles success";
-    return true;
-  } else {
-    LOG(WARNING) << "GetFiles failed";
+bool Channels::GetCachedFiles(std::vector<std::uint8_t> *files) {
+  // Read the device info only, to key the cache and validate it
+  std::bitset<8> header;
+  header[0] = true;
+  std::vector<std::uint8_t> info_files;
+  if (!QueryFiles(static_cast<std::uint8_t>(header.to_ulong()), &info_files))
     return false;
+  device_info_t info;
+  ParseFiles(info_files, &info, nullptr, nullptr);
+  auto &&key = info.serial_number + "_" + info.firmware_version.to_string();
+
+  std::vector<std::uint8_t> cached_files;
+  if (info_cache_->Load(key, &cached_files, &control_infos_)) {
+    auto &&device_info = GetFile(info_files, FID_DEVICE_INFO);
+    if (!device_info.empty() &&
+        GetFile(cached_files, FID_DEVICE_INFO) == device_info) {
+      std::promise<std::int32_t> promise;
+      promise.set_value(0);
+      control_infos_ready_ = promise.get_future().share();
+      *files = std::move(cached_files);
+      VLOG(2) << "GetFiles from the cache";
+      return true;
+    }
+    VLOG(2) << "Info cache is not of the device info now";
+    control_infos_.clear();
   }
+
+  header[1] = header[2] = true;
+  if (!QueryFiles(static_cast<std::uint8_t>(header.to_ulong()), files))
+    return false;
+  info_cache_->SetFiles(key, *files);
+  return true;
 }
 
 bool Channels::SetFiles(
@@ -567,6 +858,8 @@ bool Channels::SetFiles(
           << std::setfill('0') << static_cast<int>(data[0]);
   if (XuFileQuery(uvc::XU_QUERY_SET, 2000, data)) {
     VLOG(2) << "SetFiles success";
+    if (info_cache_)
+      info_cache_->Invalidate();
     return true;
   } else {
     LOG(WARNING) << "SetFiles failed";
@@ -635,7 +928,7 @@ std::int32_t Channels::XuCamCtrlGet(Option option) const {
   }
 }
 
-void Channels::XuCamCtrlSet(Option option, std::int32_t value) const {
+bool Channels::XuCamCtrlSet(Option option, std::int32_t value) const {
   int id = XuCamCtrlId(option);
   std::uint8_t data[3] = {static_cast<std::uint8_t>(id & 0xFF),
                           static_cast<std::uint8_t>((value >> 8) & 0xFF),
@@ -643,9 +936,11 @@ void Channels::XuCamCtrlSet(Option option, std::int32_t value) const {
   if (XuCamCtrlQuery(uvc::XU_QUERY_SET, 3, data)) {
     VLOG(2) << "XuCamCtrlSet value (" << value << ") of " << option
             << " success";
+    return true;
   } else {
     LOG(WARNING) << "XuCamCtrlSet value (" << value << ") of " << option
                  << " failed";
+    return false;
   }
 }
 
@@ -677,9 +972,9 @@ bool Channels::XuImuWrite(const ImuReqPacket &req) const {
 }
 
 bool Channels::XuImuRead(ImuResPacket *res) const {
-  static std::uint8_t data[2000]{};
-  // std::fill(data, data + 2000, 0);  // reset
-  if (XuControlQuery(CHANNEL_IMU_READ, uvc::XU_QUERY_GET, 2000, data)) {
+  std::uint8_t data[IMU_READ_SIZE]{};
+  if (XuControlQuery(
+          CHANNEL_IMU_READ, uvc::XU_QUERY_GET, IMU_READ_SIZE, data)) {
     adapter_->GetImuResPacket(data, res);
 
     if (res->header != 0x5B) {
@@ -754,6 +1049,11 @@ std::set<Option> ChannelsAdapter::GetOptionSupports() {
   return option_supports_map.at(model_);
 }
 
+std::uint32_t ChannelsAdapter::GetImuSerialSpan(const ImuPacket &packet) {
+  MYNTEYE_UNUSED(packet)
+  return 1;
+}
+
 std::set<Resolution> ChannelsAdapter::GetResolutionSupports() {
   std::set<Resolution> res;
   auto requests_map = stream_requests_map.at(model_);
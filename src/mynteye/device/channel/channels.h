@@ -15,8 +15,13 @@
 #define MYNTEYE_DEVICE_CHANNEL_CHANNELS_H_
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <thread>
 #include <vector>
@@ -38,6 +43,7 @@ struct xu;
 }  // namespace uvc
 
 class ChannelsAdapter;
+class InfoCache;
 
 class MYNTEYE_API Channels {
  public:
@@ -53,7 +59,10 @@ class MYNTEYE_API Channels {
     XU_CMD_LAST
   } xu_cmd_t;
 
-  using imu_callback_t = std::function<void(const ImuPacket &packet)>;
+  // Called once for each imu read
+  using imu_callback_t = std::function<void(const ImuResPacket &res)>;
+
+  using control_future_t = std::shared_future<std::int32_t>;
 
   using device_info_t = FileChannel::device_info_t;
   using img_params_t = FileChannel::img_params_t;
@@ -73,10 +82,25 @@ class MYNTEYE_API Channels {
   std::int32_t GetControlValue(const Option &option) const;
   void SetControlValue(const Option &option, std::int32_t value);
 
+  // Controls are queued to run in batches on the control thread. Repeated
+  // gets or sets of one option before run are coalesced, the set one gets the
+  // last value. Future value is -1 if failed, or the value got or set.
+  control_future_t GetControlValueAsync(const Option &option) const;
+  control_future_t SetControlValueAsync(
+      const Option &option, std::int32_t value);
+
   bool RunControlAction(const Option &option) const;
 
   void SetImuCallback(imu_callback_t callback);
-  void DoImuTrack();
+  // Returns true if the read returned a full packet, more may be ready
+  bool DoImuTrack();
+
+  // Target latency of imu datas, the tracking period follows it and the imu
+  // frequency, but not longer than the default period
+  void SetImuTrackLatency(std::uint32_t latency_us);
+
+  device::ImuStats GetImuStats() const;
+  void ResetImuStats();
 
   void StartImuTracking(imu_callback_t callback = nullptr);
   void StopImuTracking();
@@ -87,6 +111,28 @@ class MYNTEYE_API Channels {
       device_info_t *info, img_params_t *img_params, imu_params_t *imu_params);
 
  private:
+  typedef enum ControlType {
+    CONTROL_GET,
+    CONTROL_SET,
+    CONTROL_UPDATE_INFOS,
+  } control_type_t;
+
+  typedef struct ControlCommand {
+    control_type_t type;
+    Option option;
+    std::int32_t value;
+    std::shared_ptr<std::promise<std::int32_t>> promise;
+    control_future_t future;
+  } control_command_t;
+
+  control_future_t PushControlCommand(
+      control_type_t type, const Option &option, std::int32_t value) const;
+  void RunControlCommands();
+
+  void DoUpdateControlInfos();
+  std::int32_t DoGetControlValue(const Option &option) const;
+  bool DoSetControlValue(const Option &option, std::int32_t value);
+
   bool PuControlRange(
       Option option, int32_t *min, int32_t *max, int32_t *def) const;
   bool PuControlQuery(Option option, uvc::pu_query query, int32_t *value) const;
@@ -107,15 +153,27 @@ class MYNTEYE_API Channels {
 
   bool XuCamCtrlQuery(uvc::xu_query query, uint16_t size, uint8_t *data) const;
   std::int32_t XuCamCtrlGet(Option option) const;
-  void XuCamCtrlSet(Option option, std::int32_t value) const;
+  bool XuCamCtrlSet(Option option, std::int32_t value) const;
 
   bool XuHalfDuplexSet(Option option, xu_cmd_t cmd) const;
 
   bool XuImuWrite(const ImuReqPacket &req) const;
   bool XuImuRead(ImuResPacket *res) const;
 
+  std::uint64_t GetImuTrackPeriod() const;
+  void UpdateImuStats(std::uint64_t latency, std::size_t samples, bool full);
+
   bool XuFileQuery(uvc::xu_query query, uint16_t size, uint8_t *data) const;
 
+  // Query the files of the header, and return the records of them
+  bool QueryFiles(std::uint8_t header, std::vector<std::uint8_t> *files) const;
+  void ParseFiles(const std::vector<std::uint8_t> &files, device_info_t *info,
+      img_params_t *img_params, imu_params_t *imu_params);
+  // Read the device info, then load the files and option ranges from the
+  // cache of it, or read all the files and keep them to cache with the
+  // ranges got next
+  bool GetCachedFiles(std::vector<std::uint8_t> *files);
+
   control_info_t PuControlInfo(Option option) const;
   control_info_t XuControlInfo(Option option) const;
 
@@ -123,8 +181,16 @@ class MYNTEYE_API Channels {
   std::shared_ptr<ChannelsAdapter> adapter_;
 
   FileChannel file_channel_;
+  std::shared_ptr<InfoCache> info_cache_;
 
   std::map<Option, control_info_t> control_infos_;
+  control_future_t control_infos_ready_;
+
+  mutable std::mutex mtx_controls_;
+  mutable std::condition_variable cv_controls_;
+  mutable std::deque<control_command_t> control_cmds_;
+  bool controls_running_;
+  std::thread controls_thread_;
 
   bool is_imu_tracking_;
   std::thread imu_track_thread_;
@@ -132,6 +198,15 @@ class MYNTEYE_API Channels {
 
   std::uint32_t imu_sn_;
   imu_callback_t imu_callback_;
+
+  std::atomic<std::int32_t> imu_frequency_;
+  std::atomic<std::uint32_t> imu_track_latency_;
+
+  device::ImuStats imu_stats_;
+  mutable std::mutex mtx_imu_stats_;
+
+  ImuReqPacket imu_req_packet_;
+  ImuResPacket imu_res_packet_;
 };
 
 class ChannelsAdapter {
@@ -150,6 +225,9 @@ class ChannelsAdapter {
 
   virtual void GetImuResPacket(const std::uint8_t *data, ImuResPacket *res) = 0;
 
+  // Count of serial numbers that the packet takes, 1 by default
+  virtual std::uint32_t GetImuSerialSpan(const ImuPacket &packet);
+
  protected:
   Model model_;
 };
@@ -0,0 +1,251 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "mynteye/device/channel/info_cache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#include "mynteye/logger.h"
+#include "mynteye/util/files.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+namespace {
+
+const std::uint32_t CACHE_MAGIC = 0x4345594D;  // "MYEC"
+const std::uint16_t CACHE_VERSION = 1;
+
+void write_u16(InfoCache::bytes_t *data, std::uint16_t value) {
+  data->push_back(static_cast<std::uint8_t>(value & 0xFF));
+  data->push_back(static_cast<std::uint8_t>((value >> 8) & 0xFF));
+}
+
+void write_u32(InfoCache::bytes_t *data, std::uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    data->push_back(static_cast<std::uint8_t>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+void write_bytes(InfoCache::bytes_t *data, const InfoCache::bytes_t &bytes) {
+  write_u16(data, static_cast<std::uint16_t>(bytes.size()));
+  data->insert(data->end(), bytes.begin(), bytes.end());
+}
+
+// Reads the cached data in order, fails once out of the end
+class Reader {
+ public:
+  Reader(const std::uint8_t *data, std::size_t size)
+      : data_(data), size_(size), i_(0), ok_(true) {}
+
+  bool ok() const {
+    return ok_;
+  }
+
+  std::uint32_t u32(std::size_t n = 4) {
+    if (!Has(n))
+      return 0;
+    std::uint32_t value = 0;
+    for (std::size_t k = 0; k < n; k++) {
+      value |= static_cast<std::uint32_t>(data_[i_ + k]) << (8 * k);
+    }
+    i_ += n;
+    return value;
+  }
+
+  std::uint16_t u16() {
+    return static_cast<std::uint16_t>(u32(2));
+  }
+
+  InfoCache::bytes_t bytes() {
+    std::size_t n = u16();
+    if (!Has(n))
+      return {};
+    InfoCache::bytes_t value(data_ + i_, data_ + i_ + n);
+    i_ += n;
+    return value;
+  }
+
+ private:
+  bool Has(std::size_t n) {
+    ok_ = ok_ && i_ + n <= size_;
+    return ok_;
+  }
+
+  const std::uint8_t *data_;
+  std::size_t size_;
+  std::size_t i_;
+  bool ok_;
+};
+
+// FNV-1a, to tell the broken files
+std::uint32_t checksum(const std::uint8_t *data, std::size_t size) {
+  std::uint32_t hash = 2166136261u;
+  for (std::size_t i = 0; i < size; i++) {
+    hash = (hash ^ data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+std::string file_name(const std::string &s) {
+  std::string name;
+  for (auto &&c : s) {
+    bool ok = std::isalnum(static_cast<unsigned char>(c)) || c == '-' ||
+        c == '.';
+    name.push_back(ok ? c : '_');
+  }
+  return name;
+}
+
+}  // namespace
+
+InfoCache::InfoCache(const std::string &dir)
+    : dir_(dir), files_pending_(false) {
+  VLOG(2) << __func__ << ": " << dir_;
+}
+
+std::string InfoCache::GetDir() {
+  const char *dir = std::getenv("MYNTEYE_CACHE_DIR");
+  return dir ? dir : "";
+}
+
+bool InfoCache::Load(const std::string &key, bytes_t *files,
+    control_infos_t *control_infos) {
+  std::lock_guard<std::mutex> _(mtx_);
+  key_ = key;
+  path_ = GetPath(key);
+  std::ifstream ifs(path_, std::ios::binary);
+  if (!ifs.is_open()) {
+    VLOG(2) << "Info cache not found: " << path_;
+    return false;
+  }
+  bytes_t data{std::istreambuf_iterator<char>(ifs),
+      std::istreambuf_iterator<char>()};
+  if (data.size() < 4) {
+    LOG(WARNING) << "Info cache is broken: " << path_;
+    return false;
+  }
+
+  std::size_t size = data.size() - 4;
+  Reader end(data.data() + size, 4);
+  if (end.u32() != checksum(data.data(), size)) {
+    LOG(WARNING) << "Info cache is broken: " << path_;
+    return false;
+  }
+  Reader reader(data.data(), size);
+  if (reader.u32() != CACHE_MAGIC || reader.u16() != CACHE_VERSION) {
+    VLOG(2) << "Info cache is not of this version: " << path_;
+    return false;
+  }
+  auto &&cached_key = reader.bytes();
+  if (cached_key.size() != key.size() ||
+      !std::equal(key.begin(), key.end(), cached_key.begin())) {
+    VLOG(2) << "Info cache is of another key: " << path_;
+    return false;
+  }
+  bytes_t cached_files = reader.bytes();
+  control_infos_t cached_infos;
+  for (std::size_t i = 0, n = reader.u16(); i < n && reader.ok(); i++) {
+    auto &&option = static_cast<Option>(reader.u32(1));
+    auto &&control_info = cached_infos[option];
+    control_info.min = static_cast<std::int32_t>(reader.u32());
+    control_info.max = static_cast<std::int32_t>(reader.u32());
+    control_info.def = static_cast<std::int32_t>(reader.u32());
+  }
+  if (!reader.ok()) {
+    LOG(WARNING) << "Info cache is broken: " << path_;
+    return false;
+  }
+
+  *files = std::move(cached_files);
+  *control_infos = std::move(cached_infos);
+  VLOG(2) << "Info cache loaded: " << path_;
+  return true;
+}
+
+void InfoCache::SetFiles(const std::string &key, const bytes_t &files) {
+  std::lock_guard<std::mutex> _(mtx_);
+  key_ = key;
+  path_ = GetPath(key);
+  files_ = files;
+  files_pending_ = true;
+}
+
+bool InfoCache::Save(const control_infos_t &control_infos) {
+  std::lock_guard<std::mutex> _(mtx_);
+  if (!files_pending_)
+    return false;
+  files_pending_ = false;
+
+  bytes_t data;
+  write_u32(&data, CACHE_MAGIC);
+  write_u16(&data, CACHE_VERSION);
+  write_bytes(&data, bytes_t(key_.begin(), key_.end()));
+  write_bytes(&data, files_);
+  write_u16(&data, static_cast<std::uint16_t>(control_infos.size()));
+  for (auto &&it : control_infos) {
+    data.push_back(static_cast<std::uint8_t>(it.first));
+    write_u32(&data, static_cast<std::uint32_t>(it.second.min));
+    write_u32(&data, static_cast<std::uint32_t>(it.second.max));
+    write_u32(&data, static_cast<std::uint32_t>(it.second.def));
+  }
+  write_u32(&data, checksum(data.data(), data.size()));
+
+  if (!files::mkdir(dir_)) {
+    LOG(WARNING) << "Create info cache dir failed: " << dir_;
+    return false;
+  }
+  // Write aside then rename, as other processes may load it meanwhile
+  std::string path_tmp = path_ + ".tmp";
+  {
+    std::ofstream ofs(path_tmp, std::ios::binary | std::ios::trunc);
+    ofs.write(reinterpret_cast<const char *>(data.data()), data.size());
+    if (!ofs.good()) {
+      LOG(WARNING) << "Write info cache failed: " << path_tmp;
+      std::remove(path_tmp.c_str());
+      return false;
+    }
+  }
+  if (std::rename(path_tmp.c_str(), path_.c_str()) != 0) {
+    // rename not replaces the existing one on some platforms
+    std::remove(path_.c_str());
+    if (std::rename(path_tmp.c_str(), path_.c_str()) != 0) {
+      LOG(WARNING) << "Write info cache failed: " << path_;
+      std::remove(path_tmp.c_str());
+      return false;
+    }
+  }
+  VLOG(2) << "Info cache saved: " << path_;
+  return true;
+}
+
+void InfoCache::Invalidate() {
+  std::lock_guard<std::mutex> _(mtx_);
+  files_pending_ = false;
+  if (path_.empty())
+    return;
+  if (std::remove(path_.c_str()) == 0) {
+    VLOG(2) << "Info cache removed: " << path_;
+  }
+}
+
+std::string InfoCache::GetPath(const std::string &key) const {
+  return dir_ + MYNTEYE_OS_SEP + file_name(key) + ".bin";
+}
+
+MYNTEYE_END_NAMESPACE
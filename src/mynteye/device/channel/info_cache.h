@@ -0,0 +1,82 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef MYNTEYE_DEVICE_CHANNEL_INFO_CACHE_H_
+#define MYNTEYE_DEVICE_CHANNEL_INFO_CACHE_H_
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "mynteye/mynteye.h"
+#include "mynteye/types.h"
+#include "mynteye/device/channel/channels.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+// Cache of the device files and option ranges on disk, to open the device
+// without reading them again.
+//
+// Set MYNTEYE_CACHE_DIR=<dir> to enable it. Each device is cached in
+// <dir>/<key>.bin, keyed by its serial number and firmware version. Only the
+// device info is read on open, the cache is used if it has the same one,
+// otherwise the files are read again and cached.
+//
+// File of a device, integers in little endian:
+//   u32 magic, u16 format version
+//   u16 size then data: the key
+//   u16 size then data: the files, as the records got from the device
+//   u16 count then each: u8 option, i32 min, i32 max, i32 def
+//   u32 checksum of all above
+class InfoCache {
+ public:
+  using bytes_t = std::vector<std::uint8_t>;
+  using control_infos_t = std::map<Option, Channels::control_info_t>;
+
+  explicit InfoCache(const std::string &dir);
+
+  // The cache dir of the environment, empty if not set
+  static std::string GetDir();
+
+  // Load the cache of the key, returns false if not cached or invalid
+  bool Load(const std::string &key, bytes_t *files,
+      control_infos_t *control_infos);
+
+  // Keep the files to save, until the option ranges are got
+  void SetFiles(const std::string &key, const bytes_t &files);
+  // Save the kept files with the option ranges, no-op if no files kept
+  bool Save(const control_infos_t &control_infos);
+
+  // Remove the cache of the device, as its files changed
+  void Invalidate();
+
+ private:
+  std::string GetPath(const std::string &key) const;
+
+  std::string dir_;
+  // Key and path of the device, once it is loaded or to save
+  std::string key_;
+  std::string path_;
+
+  bytes_t files_;
+  bool files_pending_;
+
+  std::mutex mtx_;
+};
+
+MYNTEYE_END_NAMESPACE
+
+#endif  // MYNTEYE_DEVICE_CHANNEL_INFO_CACHE_H_
@@ -13,6 +13,8 @@
 // limitations under the License.
 #include "mynteye/device/context.h"
 
+#include <thread>
+
 #include "mynteye/logger.h"
 
 #include "mynteye/device/device.h"
@@ -23,26 +25,102 @@ MYNTEYE_BEGIN_NAMESPACE
 Context::Context() : context_(uvc::create_context()) {
   VLOG(2) << __func__;
 
-  for (auto &&device : uvc::query_devices(context_)) {
-    auto name = uvc::get_name(*device);
-    auto vid = uvc::get_vendor_id(*device);
-    auto pid = uvc::get_product_id(*device);
-    // auto video_name = uvc::get_video_name(*device);
-    VLOG(2) << "UVC device detected, name: " << name << ", vid: 0x" << std::hex
-            << vid << ", pid: 0x" << std::hex << pid;
-    if (vid == MYNTEYE_VID) {
-      auto d = Device::Create(name, device);
-      if (d) {
-        devices_.push_back(d);
-      } else {
-        LOG(ERROR) << "Device is not supported by MYNT EYE.";
-      }
-    }
+  for (auto &&desc : uvc::query_device_descs(context_)) {
+    VLOG(2) << "UVC device detected, name: " << desc.name << ", vid: 0x"
+            << std::hex << desc.vid << ", pid: 0x" << std::hex << desc.pid
+            << ", bus: " << desc.bus_path;
+    if (desc.vid != MYNTEYE_VID)
+      continue;
+    uvc_descs_.push_back(std::make_shared<uvc::device_desc>(desc));
+    device::DeviceDesc d;
+    d.name = desc.name;
+    d.vid = desc.vid;
+    d.pid = desc.pid;
+    d.serial = desc.serial;
+    d.bus_path = desc.bus_path;
+    descs_.push_back(d);
   }
+  devices_.resize(descs_.size());
 }
 
 Context::~Context() {
   VLOG(2) << __func__;
 }
 
+std::shared_ptr<Device> Context::Open(std::size_t index) const {
+  if (index >= uvc_descs_.size()) {
+    LOG(ERROR) << "Device index out of range: " << index;
+    return nullptr;
+  }
+  {
+    std::lock_guard<std::mutex> _(mtx_devices_);
+    if (devices_[index])
+      return devices_[index];
+  }
+  auto &&desc = *uvc_descs_[index];
+  auto &&device = uvc::open_device(context_, desc);
+  if (!device)
+    return nullptr;
+  auto d = Device::Create(uvc::get_name(*device), device);
+  if (!d) {
+    LOG(ERROR) << "Device is not supported by MYNT EYE.";
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> _(mtx_devices_);
+  if (!devices_[index])
+    devices_[index] = d;
+  return devices_[index];
+}
+
+std::vector<std::shared_ptr<Device>> Context::devices() const {
+  // Opening reads the device infos and controls, which is slow, so do it
+  // concurrently for each device
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < uvc_descs_.size(); i++) {
+    threads.emplace_back([this, i]() { Open(i); });
+  }
+  for (auto &&thread : threads) {
+    thread.join();
+  }
+  return opened_devices();
+}
+
+std::vector<std::shared_ptr<Device>> Context::opened_devices() const {
+  std::vector<std::shared_ptr<Device>> devices;
+  std::lock_guard<std::mutex> _(mtx_devices_);
+  for (auto &&device : devices_) {
+    if (device)
+      devices.push_back(device);
+  }
+  return devices;
+}
+
+void Context::Start(const Source &source) {
+  std::vector<std::thread> threads;
+  for (auto &&device : opened_devices()) {
+    threads.emplace_back([device, source]() { device->Start(source); });
+  }
+  for (auto &&thread : threads) {
+    thread.join();
+  }
+}
+
+void Context::Stop(const Source &source) {
+  std::vector<std::thread> threads;
+  for (auto &&device : opened_devices()) {
+    threads.emplace_back([device, source]() { device->Stop(source); });
+  }
+  for (auto &&thread : threads) {
+    thread.join();
+  }
+}
+
+device::CaptureStats Context::GetCaptureStats() const {
+  device::CaptureStats stats;
+  for (auto &&device : opened_devices()) {
+    stats += device->GetCaptureStats();
+  }
+  return stats;
+}
+
 MYNTEYE_END_NAMESPACE
@@ -14,6 +14,9 @@
 #include "mynteye/device/device.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <iterator>
 #include <limits>
 #include <stdexcept>
@@ -29,6 +32,7 @@
 #include "mynteye/device/standard2/device_s210a.h"
 #include "mynteye/device/streams.h"
 #include "mynteye/device/types.h"
+#include "mynteye/util/enum_map.h"
 #include "mynteye/util/strings.h"
 #include "mynteye/util/times.h"
 #include "mynteye/uvc/uvc.h"
@@ -78,8 +82,29 @@ bool CheckSupports(
   }
 }
 
+std::shared_future<std::int32_t> ready_future(std::int32_t value) {
+  std::promise<std::int32_t> promise;
+  promise.set_value(value);
+  return promise.get_future().share();
+}
+
+std::uint64_t steady_now_us() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 }  // namespace
 
+struct Device::MotionCallbacks {
+  motion_callback_t callback;
+  motion_async_callback_ptr_t async_callback;
+};
+
+struct Device::StreamCallbacks {
+  EnumMap<Stream, stream_callback_t> callbacks;
+  EnumMap<Stream, stream_async_callback_ptr_t> async_callbacks;
+};
+
 Device::Device(const Model &model,
     const std::shared_ptr<uvc::device> &device,
     const std::shared_ptr<StreamsAdapter> &streams_adapter,
@@ -88,10 +113,15 @@ Device::Device(const Model &model,
     motion_tracking_(false),
     model_(model),
     device_(device),
+    zero_copy_(false),
+    capture_buffer_count_(0),
     streams_(std::make_shared<Streams>(streams_adapter)),
+    capture_sequence_(0),
     channels_(std::make_shared<Channels>(device_, channels_adapter)),
     motions_(std::make_shared<Motions>(channels_)) {
   VLOG(2) << __func__;
+  stream_callbacks_ = std::make_shared<StreamCallbacks>();
+  motion_callbacks_ = std::make_shared<MotionCallbacks>();
   ReadAllInfos();
 }
 
@@ -366,6 +396,27 @@ void Device::SetOptionValue(const Option &option, std::int32_t value) {
   channels_->SetControlValue(option, value);
 }
 
+std::shared_future<std::int32_t> Device::GetOptionValueAsync(
+    const Option &option) const {
+  if (!Supports(option)) {
+    if (option == Option::FRAME_RATE) {
+      return ready_future(GetStreamRequest().fps);
+    }
+    LOG(WARNING) << "Unsupported option: " << option;
+    return ready_future(-1);
+  }
+  return channels_->GetControlValueAsync(option);
+}
+
+std::shared_future<std::int32_t> Device::SetOptionValueAsync(
+    const Option &option, std::int32_t value) {
+  if (!Supports(option)) {
+    LOG(WARNING) << "Unsupported option: " << option;
+    return ready_future(-1);
+  }
+  return channels_->SetControlValueAsync(option, value);
+}
+
 bool Device::RunOptionAction(const Option &option) const {
   if (!Supports(option)) {
     LOG(WARNING) << "Unsupported option: " << option;
@@ -379,40 +430,185 @@ void Device::SetStreamCallback(
   if (!CheckSupports(this, stream, false)) {
     return;
   }
+  std::lock_guard<std::mutex> _(mtx_stream_callbacks_);
+  // copy, update and publish, the capture thread may read the old one
+  auto &&callbacks =
+      std::make_shared<StreamCallbacks>(*std::atomic_load(&stream_callbacks_));
   if (callback) {
-    stream_callbacks_[stream] = callback;
-    if (async)
-      stream_async_callbacks_[stream] =
+    callbacks->callbacks[stream] = callback;
+    if (async) {
+      callbacks->async_callbacks[stream] =
           std::make_shared<stream_async_callback_t>(
               to_string(stream), callback);  // max_data_size = 1
+    } else {
+      callbacks->async_callbacks.erase(stream);
+    }
   } else {
-    stream_callbacks_.erase(stream);
-    stream_async_callbacks_.erase(stream);
+    callbacks->callbacks.erase(stream);
+    callbacks->async_callbacks.erase(stream);
+  }
+  std::atomic_store(&stream_callbacks_,
+      std::shared_ptr<const StreamCallbacks>(callbacks));
+  if (stream_demands_.find(stream) == stream_demands_.end()) {
+    streams_->SetStreamDemanded(stream, callback != nullptr);
   }
 }
 
 void Device::SetMotionCallback(motion_callback_t callback, bool async) {
-  motion_callback_ = callback;
-  if (callback) {
-    if (async)
-      motion_async_callback_ =
-          std::make_shared<motion_async_callback_t>("motion", callback, 1000);
+  auto &&callbacks = std::make_shared<MotionCallbacks>();
+  callbacks->callback = callback;
+  if (callback && async) {
+    callbacks->async_callback =
+        std::make_shared<motion_async_callback_t>("motion", callback, 1000);
     // will drop old motion datas after callback cost > 2 s (1000 / 500 Hz)
-  } else {
-    motion_async_callback_ = nullptr;
+  }
+  std::atomic_store(&motion_callbacks_,
+      std::shared_ptr<const MotionCallbacks>(callbacks));
+  if (motion_tracking_) {
+    if (callback) {
+      motions_->SetMotionCallback(
+          std::bind(&Device::CallbackMotionData, this, std::placeholders::_1));
+    } else {
+      motions_->SetMotionCallback(nullptr);
+    }
   }
 }
 
-bool Device::HasStreamCallback(const Stream &stream) const {
-  try {
-    return stream_callbacks_.at(stream) != nullptr;
-  } catch (const std::out_of_range &e) {
+void Device::SetMotionBatchCallback(motion_batch_callback_t callback) {
+  motions_->SetMotionBatchCallback(callback);
+}
+
+void Device::EnableMotionMerge(bool enabled) {
+  if (motion_tracking_) {
+    LOG(WARNING) << "Cannot enable motion merge while motion tracking";
+    return;
+  }
+  motions_->EnableMerge(enabled);
+}
+
+void Device::SetPreintegrationCallback(
+    preintegration_callback_t callback) {
+  if (video_streaming_ || motion_tracking_) {
+    LOG(WARNING) << "Cannot set preintegration callback while streaming";
+    return;
+  }
+  motions_->SetPreintegrationCallback(callback);
+}
+
+void Device::EnableImuHistory(std::size_t capacity) {
+  if (motion_tracking_) {
+    LOG(WARNING) << "Cannot enable imu history while motion tracking";
+    return;
+  }
+  motions_->EnableHistory(capacity);
+}
+
+std::vector<ImuData> Device::GetImuRange(
+    std::uint64_t t0, std::uint64_t t1) {
+  return motions_->GetHistoryRange(t0, t1);
+}
+
+bool Device::InterpolateImu(std::uint64_t timestamp, ImuData *imu) {
+  CHECK_NOTNULL(imu);
+  return motions_->InterpolateHistory(timestamp, imu);
+}
+
+bool Device::EnableMotionCalibration(bool enabled) {
+  if (motion_tracking_) {
+    LOG(WARNING) << "Cannot enable motion calibration while motion tracking";
+    return false;
+  }
+  if (!enabled) {
+    motions_->SetCalibration(nullptr);
+    return true;
+  }
+  if (!motion_intrinsics_) {
+    LOG(WARNING) << "Cannot enable motion calibration without intrinsics";
     return false;
   }
+  motions_->SetCalibration(motion_intrinsics_.get());
+  return true;
+}
+
+bool Device::HasStreamCallback(const Stream &stream) const {
+  auto &&callback =
+      std::atomic_load(&stream_callbacks_)->callbacks.find(stream);
+  return callback && *callback;
 }
 
 bool Device::HasMotionCallback() const {
-  return motion_callback_ != nullptr;
+  return std::atomic_load(&motion_callbacks_)->callback != nullptr;
+}
+
+bool Device::EnableZeroCopy() {
+  if (video_streaming_) {
+    LOG(WARNING) << "Cannot enable zero copy while video streaming";
+    return false;
+  }
+  zero_copy_ = uvc::set_zero_copy(*device_, true);
+  return zero_copy_;
+}
+
+void Device::DisableZeroCopy() {
+  if (video_streaming_) {
+    LOG(WARNING) << "Cannot disable zero copy while video streaming";
+    return;
+  }
+  uvc::set_zero_copy(*device_, false);
+  zero_copy_ = false;
+}
+
+void Device::SetCaptureBufferCount(std::uint32_t count) {
+  if (video_streaming_) {
+    LOG(WARNING) << "Cannot set capture buffer count while video streaming";
+    return;
+  }
+  capture_buffer_count_ = count;
+}
+
+void Device::EnableParallelUnpack(bool enabled) {
+  if (video_streaming_) {
+    LOG(WARNING) << "Cannot enable parallel unpack while video streaming";
+    return;
+  }
+  streams_->EnableParallelUnpack(enabled);
+}
+
+void Device::EnableLumaOnly(bool enabled) {
+  if (video_streaming_) {
+    LOG(WARNING) << "Cannot enable luma only while video streaming";
+    return;
+  }
+  streams_->EnableLumaOnly(enabled);
+}
+
+void Device::EnableImgStats(bool enabled) {
+  if (video_streaming_) {
+    LOG(WARNING) << "Cannot enable img stats while video streaming";
+    return;
+  }
+  streams_->EnableImgStats(enabled);
+}
+
+void Device::SetStreamDemanded(const Stream &stream, bool demanded) {
+  stream_demands_[stream] = demanded;
+  streams_->SetStreamDemanded(stream, demanded);
+}
+
+void Device::SetFramePoolSize(std::size_t size) {
+  if (video_streaming_) {
+    LOG(WARNING) << "Cannot set frame pool size while video streaming";
+    return;
+  }
+  streams_->ConfigFramePool(size);
+}
+
+void Device::SetStreamDataMaxSize(const Stream &stream, std::size_t size) {
+  if (video_streaming_) {
+    LOG(WARNING) << "Cannot set stream data max size while video streaming";
+    return;
+  }
+  streams_->ConfigStreamLimits(stream, size);
 }
 
 void Device::Start(const Source &source) {
@@ -453,7 +649,6 @@ device::StreamData Device::GetStreamData(const Stream &stream) {
   CHECK(video_streaming_);
   CHECK_NOTNULL(streams_);
   CheckSupports(this, stream);
-  std::lock_guard<std::mutex> _(mtx_streams_);
   return streams_->GetLatestStreamData(stream);
 }
 
@@ -465,7 +660,6 @@ std::vector<device::StreamData> Device::GetStreamDatas(const Stream &stream) {
   CHECK(video_streaming_);
   CHECK_NOTNULL(streams_);
   CheckSupports(this, stream);
-  std::lock_guard<std::mutex> _(mtx_streams_);
   return streams_->GetStreamDatas(stream);
 }
 
@@ -489,6 +683,66 @@ std::vector<device::MotionData> Device::GetMotionDatas() {
   return motions_->GetMotionDatas();
 }
 
+device::CaptureStats Device::GetCaptureStats() {
+  std::lock_guard<std::mutex> _(mtx_capture_stats_);
+  auto stats = capture_stats_;
+  streams_->GetFramePoolStats(
+      &stats.frame_pool_hits, &stats.frame_pool_misses);
+  return stats;
+}
+
+void Device::ResetCaptureStats() {
+  std::lock_guard<std::mutex> _(mtx_capture_stats_);
+  capture_stats_ = {};
+  capture_sequence_ = 0;
+  streams_->ResetFramePoolStats();
+}
+
+void Device::SetImuTargetLatency(std::uint32_t latency_ms) {
+  channels_->SetImuTrackLatency(latency_ms * 1000);
+}
+
+device::ImuStats Device::GetImuStats() {
+  return channels_->GetImuStats();
+}
+
+void Device::ResetImuStats() {
+  channels_->ResetImuStats();
+}
+
+bool Device::SetCaptureAffinity(int cpu) {
+  if (video_streaming_) {
+    LOG(WARNING) << "Cannot set capture affinity while video streaming";
+    return false;
+  }
+  return uvc::set_capture_affinity(*device_, cpu);
+}
+
+bool Device::SetStreamRecovery(
+    const device::RecoveryConfig &config, device::RecoveryCallback callback) {
+  if (video_streaming_) {
+    LOG(WARNING) << "Cannot set stream recovery while video streaming";
+    return false;
+  }
+  uvc::recovery_config recovery;
+  recovery.no_data_timeout_ms = config.no_data_timeout;
+  recovery.restart_timeout_ms = config.restart_timeout;
+  return uvc::set_recovery(
+      *device_, recovery, [this, callback](const uvc::recovery_event &event) {
+        {
+          std::lock_guard<std::mutex> _(mtx_capture_stats_);
+          ++capture_stats_.recoveries_count;
+          capture_stats_.recovery_downtime_total += event.downtime;
+        }
+        if (callback) {
+          device::RecoveryEvent recovered;
+          recovered.tier = event.tier;
+          recovered.downtime = event.downtime;
+          callback(recovered);
+        }
+      });
+}
+
 void Device::StartVideoStreaming() {
   if (video_streaming_) {
     LOG(WARNING) << "Cannot start video streaming without first stopping it";
@@ -511,37 +765,49 @@ void Device::StartVideoStreaming() {
     auto &&stream_request = GetStreamRequest(stream_cap);
     streams_->ConfigStream(stream_cap, stream_request);
 
+    std::uint8_t drop_count = 1;
     uvc::set_device_mode(
         *device_, stream_request.width, stream_request.height,
         static_cast<int>(stream_request.format), stream_request.fps,
-        [this, stream_cap](
-            const void *data, std::function<void()> continuation) {
+        [this, stream_cap, drop_count](const void *data,
+            const uvc::frame_info &info,
+            std::function<void()> continuation) mutable {
           // drop the first stereo stream data
-          static std::uint8_t drop_count = 1;
           if (drop_count > 0) {
             --drop_count;
             continuation();
             return;
           }
-          // auto &&time_beg = times::now();
-          {
-            std::lock_guard<std::mutex> _(mtx_streams_);
-            if (streams_->PushStream(stream_cap, data)) {
-              CallbackPushedStreamData(Stream::LEFT);
-              CallbackPushedStreamData(Stream::RIGHT);
-            }
+          auto &&time_beg = steady_now_us();
+          std::int64_t latency = -1;  // dequeued to callback
+          bool pushed = false;
+          // requeue the buffer after all frames viewing it released
+          std::shared_ptr<void> holder;
+          if (zero_copy_) {
+            holder = std::shared_ptr<void>(nullptr,
+                [continuation](void *) { continuation(); });
+          }
+          // publish to the lock free rings of streams, readers never wait
+          pushed = streams_->PushStream(stream_cap, data, info, holder);
+          // requeue as soon as unpacked, not waiting for callbacks
+          if (!zero_copy_) continuation();
+          if (pushed) {
+            if (info.dequeue_timestamp > 0)
+              latency = steady_now_us() - info.dequeue_timestamp;
+            motions_->PushFrame(streams_->pushed_img_data());
+            CallbackPushedStreamData(Stream::LEFT);
+            CallbackPushedStreamData(Stream::RIGHT);
           }
-          continuation();
           OnStereoStreamUpdate();
-          // VLOG(2) << "Stereo video callback cost "
-          //     << times::count<times::milliseconds>(times::now() - time_beg)
-          //     << " ms";
+          UpdateCaptureStats(
+              info.sequence, pushed, latency, time_beg, steady_now_us());
         });
   } else {
     LOG(FATAL) << "Not any stream capabilities are supported by this device";
   }
 
-  uvc::start_streaming(*device_, 0);
+  uvc::start_streaming(
+      *device_, static_cast<int>(capture_buffer_count_));
   video_streaming_ = true;
 }
 
@@ -562,9 +828,12 @@ void Device::StartMotionTracking() {
     LOG(WARNING) << "Cannot start motion tracking without first stopping it";
     return;
   }
-  motions_->SetMotionCallback(
-      std::bind(&Device::CallbackMotionData, this, std::placeholders::_1));
-  // motions_->StartMotionTracking();
+  // Not to make motion datas one by one if only batches are called back
+  if (HasMotionCallback()) {
+    motions_->SetMotionCallback(
+        std::bind(&Device::CallbackMotionData, this, std::placeholders::_1));
+  }
+  motions_->StartMotionTracking();
   motion_tracking_ = true;
 }
 
@@ -573,7 +842,7 @@ void Device::StopMotionTracking() {
     LOG(WARNING) << "Cannot stop motion tracking without first starting it";
     return;
   }
-  // motions_->StopMotionTracking();
+  motions_->StopMotionTracking();
   motion_tracking_ = false;
 }
 
@@ -670,25 +939,57 @@ void Device::UpdateStreamIntrinsics(
 }
 
 void Device::CallbackPushedStreamData(const Stream &stream) {
-  if (HasStreamCallback(stream)) {
-    auto &&datas = streams_->stream_datas(stream);
-    // if (datas.size() > 0) {}
-    auto &&data = datas.back();
-    if (stream_async_callbacks_.find(stream) != stream_async_callbacks_.end()) {
-      stream_async_callbacks_.at(stream)->PushData(data);
-    } else {
-      stream_callbacks_.at(stream)(data);
+  auto &&callbacks = std::atomic_load(&stream_callbacks_);
+  auto &&callback = callbacks->callbacks.find(stream);
+  if (!callback || !*callback || !streams_->IsStreamDemanded(stream)) {
+    return;
+  }
+  auto &&data = streams_->pushed_stream_data(stream);
+  auto &&async_callback = callbacks->async_callbacks.find(stream);
+  if (async_callback) {
+    (*async_callback)->PushData(data);
+  } else {
+    (*callback)(data);
+  }
+}
+
+void Device::UpdateCaptureStats(std::uint32_t sequence, bool pushed,
+    std::int64_t latency, std::uint64_t time_beg, std::uint64_t time_end) {
+  std::lock_guard<std::mutex> _(mtx_capture_stats_);
+  auto &&stats = capture_stats_;
+  if (stats.frames_count == 0) {
+    stats.first_time = time_beg;
+  } else if (sequence > capture_sequence_ + 1) {
+    // Sequence restarts from 0 if capture restarted
+    stats.sequence_gaps += sequence - capture_sequence_ - 1;
+  }
+  capture_sequence_ = sequence;
+  stats.last_time = time_beg;
+  ++stats.frames_count;
+  if (!pushed)
+    ++stats.dropped_count;
+
+  if (latency >= 0) {
+    std::size_t i = 0;
+    while (i + 1 < device::CaptureStats::LATENCY_BUCKETS &&
+           latency >= (1000 << i)) {
+      ++i;
     }
+    ++stats.latency_histogram[i];
+    stats.latency_max =
+        std::max(stats.latency_max, static_cast<std::uint64_t>(latency));
   }
+  auto &&callback_time = time_end - time_beg;
+  stats.callback_time_total += callback_time;
+  stats.callback_time_max = std::max(stats.callback_time_max, callback_time);
 }
 
 void Device::CallbackMotionData(const device::MotionData &data) {
-  if (HasMotionCallback()) {
-    if (motion_async_callback_) {
-      motion_async_callback_->PushData(data);
-    } else {
-      motion_callback_(data);
-    }
+  auto &&callbacks = std::atomic_load(&motion_callbacks_);
+  if (callbacks->async_callback) {
+    callbacks->async_callback->PushData(data);
+  } else if (callbacks->callback) {
+    callbacks->callback(data);
   }
 }
 
@@ -0,0 +1,104 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "mynteye/device/frame_pool.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef MYNTEYE_OS_WIN
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "mynteye/logger.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+namespace {
+
+// Slabs as large as a huge page are aligned to it, so that could be backed
+// by huge pages
+constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+std::size_t align_up(std::size_t n, std::size_t alignment) {
+  return (n + alignment - 1) / alignment * alignment;
+}
+
+std::shared_ptr<std::uint8_t> alloc_slab(std::size_t bytes_n) {
+  std::size_t alignment =
+      bytes_n >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : CACHE_LINE_SIZE;
+  bytes_n = align_up(bytes_n, alignment);
+#ifdef MYNTEYE_OS_WIN
+  void *p = _aligned_malloc(bytes_n, alignment);
+  if (!p)
+    throw std::bad_alloc();
+  return std::shared_ptr<std::uint8_t>(
+      static_cast<std::uint8_t *>(p), [](std::uint8_t *p) {
+        _aligned_free(p);
+      });
+#else
+  void *p = nullptr;
+  if (posix_memalign(&p, alignment, bytes_n) != 0)
+    throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+  if (alignment == HUGE_PAGE_SIZE && madvise(p, bytes_n, MADV_HUGEPAGE) != 0)
+    VLOG(2) << "Frame slab is not backed by huge pages";
+#endif
+  return std::shared_ptr<std::uint8_t>(
+      static_cast<std::uint8_t *>(p), [](std::uint8_t *p) { free(p); });
+#endif
+}
+
+}  // namespace
+
+FramePool::FramePool(std::uint16_t width, std::uint16_t height, Format format,
+    std::size_t size)
+    : width_(width), height_(height), format_(format) {
+  VLOG(2) << __func__ << " " << width << "x" << height << " " << format
+          << " of " << size;
+  std::size_t step = width * bytes_per_pixel(format);
+  // each frame begins at a cache line
+  std::size_t frame_bytes_n = align_up(step * height, CACHE_LINE_SIZE);
+  if (size > 0)
+    slab_ = alloc_slab(frame_bytes_n * size);
+  frames_.reset(new ObjectPool<frame_t>(size,
+      [this, step, frame_bytes_n, size](std::size_t i) {
+        if (i < size) {
+          // views the slab, which is kept by each frame
+          return std::make_shared<frame_t>(width_, height_, format_,
+              slab_.get() + frame_bytes_n * i, step, slab_);
+        }
+        return std::make_shared<frame_t>(width_, height_, format_, nullptr);
+      }));
+}
+
+FramePool::~FramePool() {
+  VLOG(2) << __func__;
+}
+
+bool FramePool::Matches(
+    std::uint16_t width, std::uint16_t height, Format format) const {
+  return width_ == width && height_ == height && format_ == format;
+}
+
+std::shared_ptr<FramePool::frame_t> FramePool::Acquire() {
+  auto &&frame = frames_->Acquire();
+  // pixels will be changed
+  frame->ResetConverted();
+  return frame;
+}
+
+MYNTEYE_END_NAMESPACE
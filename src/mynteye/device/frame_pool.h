@@ -0,0 +1,71 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef MYNTEYE_DEVICE_FRAME_POOL_H_
+#define MYNTEYE_DEVICE_FRAME_POOL_H_
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "mynteye/mynteye.h"
+#include "mynteye/types.h"
+#include "mynteye/device/callbacks.h"
+#include "mynteye/util/object_pool.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+// Frames of one size, whose pixels are in one aligned slab. A frame returns
+// to the pool once its last reference outside is released.
+class FramePool {
+ public:
+  using frame_t = device::Frame;
+
+  FramePool(std::uint16_t width, std::uint16_t height, Format format,
+      std::size_t size);
+  ~FramePool();
+
+  bool Matches(std::uint16_t width, std::uint16_t height, Format format) const;
+
+  std::size_t size() const {
+    return frames_->size();
+  }
+
+  // Returns a free frame, or a new one out of pool if none is free
+  std::shared_ptr<frame_t> Acquire();
+
+  std::uint64_t hits() const {
+    return frames_->hits();
+  }
+
+  std::uint64_t misses() const {
+    return frames_->misses();
+  }
+
+  void ResetStats() {
+    frames_->ResetStats();
+  }
+
+ private:
+  std::uint16_t width_;
+  std::uint16_t height_;
+  Format format_;
+
+  std::shared_ptr<std::uint8_t> slab_;
+  std::unique_ptr<ObjectPool<frame_t>> frames_;
+};
+
+MYNTEYE_END_NAMESPACE
+
+#endif  // MYNTEYE_DEVICE_FRAME_POOL_H_
@@ -0,0 +1,177 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "mynteye/device/imu_history.h"
+
+#include <limits>
+
+#include "mynteye/logger.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+namespace {
+
+// Samples to look around for the ones having accel or gyro valid
+const std::uint64_t kInterpolateWindow = 16;
+
+std::size_t round_up_pow2(std::size_t n) {
+  std::size_t size = 1;
+  while (size < n) {
+    size <<= 1;
+  }
+  return size;
+}
+
+}  // namespace
+
+ImuHistory::ImuHistory(std::size_t capacity)
+    : slots_(round_up_pow2(capacity)),
+      mask_(slots_.size() - 1),
+      count_(0),
+      writing_(0) {
+  VLOG(2) << __func__ << ": " << slots_.size();
+}
+
+void ImuHistory::Push(const device::MotionBatch &batch) {
+  std::size_t n = batch.size();
+  std::size_t i = n > slots_.size() ? n - slots_.size() : 0;
+  if (i >= n)
+    return;
+  bool calibrated = batch.calibrated();
+  auto &&accel = calibrated ? batch.accel_calibrated : batch.accel;
+  auto &&gyro = calibrated ? batch.gyro_calibrated : batch.gyro;
+
+  std::uint64_t count = count_.load(std::memory_order_relaxed);
+  std::uint64_t count_end = count + (n - i);
+  // tell readers the slots are being overwritten, before writing them
+  writing_.store(count_end, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (; i < n; i++, count++) {
+    auto &&slot = slots_[count & mask_];
+    slot.timestamp = batch.timestamp[i];
+    slot.frame_id = batch.frame_id[i];
+    slot.flag = batch.flag[i];
+    for (int j = 0; j < 3; j++) {
+      slot.accel[j] = accel[j][i];
+      slot.gyro[j] = gyro[j][i];
+    }
+    slot.temperature = batch.temperature[i];
+  }
+  count_.store(count_end, std::memory_order_release);
+}
+
+std::vector<ImuData> ImuHistory::GetRange(
+    std::uint64_t t0, std::uint64_t t1) const {
+  std::vector<ImuData> datas;
+  while (true) {
+    datas.clear();
+    std::uint64_t count = count_.load(std::memory_order_acquire);
+    std::uint64_t begin = count > slots_.size() ? count - slots_.size() : 0;
+    std::uint64_t first = LowerBound(begin, count, t0);
+    std::uint64_t last = t1 == std::numeric_limits<std::uint64_t>::max()
+        ? count : LowerBound(first, count, t1 + 1);
+    datas.reserve(last - first);
+    for (std::uint64_t i = first; i < last; i++) {
+      auto &&s = slot(i);
+      ImuData imu;
+      imu.frame_id = s.frame_id;
+      imu.flag = s.flag;
+      imu.timestamp = s.timestamp;
+      for (int j = 0; j < 3; j++) {
+        imu.accel[j] = s.accel[j];
+        imu.gyro[j] = s.gyro[j];
+      }
+      imu.temperature = s.temperature;
+      datas.push_back(imu);
+    }
+    if (Validate(begin))
+      return datas;
+  }
+}
+
+bool ImuHistory::Interpolate(std::uint64_t timestamp, ImuData *imu) const {
+  // Interpolate the values of flag between the samples around i
+  auto lerp = [this](std::uint64_t begin, std::uint64_t end, std::uint64_t i,
+      std::uint64_t t, std::uint8_t flag, double *dst) {
+    auto valid = [flag](const Slot &s) {
+      return s.flag == 0 || s.flag == flag;
+    };
+    // the prev one at or before t, slot(begin) is not after t
+    std::uint64_t prev = slot(i).timestamp == t ? i : i - 1;
+    for (std::uint64_t k = 1; !valid(slot(prev)); k++) {
+      if (prev == begin || k == kInterpolateWindow)
+        return false;
+      --prev;
+    }
+    // the next one at or after t
+    std::uint64_t next = i;
+    for (std::uint64_t k = 1; !valid(slot(next)); k++) {
+      if (next + 1 == end || k == kInterpolateWindow)
+        return false;
+      ++next;
+    }
+    auto &&a = slot(prev);
+    auto &&b = slot(next);
+    const float *va = flag == 1 ? a.accel : a.gyro;
+    const float *vb = flag == 1 ? b.accel : b.gyro;
+    double k = 0;
+    if (b.timestamp > a.timestamp) {
+      k = static_cast<double>(t - a.timestamp) / (b.timestamp - a.timestamp);
+    }
+    for (int j = 0; j < 3; j++) {
+      dst[j] = va[j] + (vb[j] - va[j]) * k;
+    }
+    return true;
+  };
+
+  while (true) {
+    std::uint64_t count = count_.load(std::memory_order_acquire);
+    std::uint64_t begin = count > slots_.size() ? count - slots_.size() : 0;
+    if (begin == count)
+      return false;
+    std::uint64_t i = LowerBound(begin, count, timestamp);
+    bool ok = i < count && slot(begin).timestamp <= timestamp &&
+        lerp(begin, count, i, timestamp, 1, imu->accel) &&
+        lerp(begin, count, i, timestamp, 2, imu->gyro);
+    if (ok) {
+      auto &&s = slot(i);
+      imu->frame_id = s.frame_id;
+      imu->flag = 0;
+      imu->timestamp = timestamp;
+      imu->temperature = s.temperature;
+    }
+    if (Validate(begin))
+      return ok;
+  }
+}
+
+std::uint64_t ImuHistory::LowerBound(
+    std::uint64_t begin, std::uint64_t end, std::uint64_t t) const {
+  while (begin < end) {
+    std::uint64_t mid = begin + (end - begin) / 2;
+    if (slot(mid).timestamp < t) {
+      begin = mid + 1;
+    } else {
+      end = mid;
+    }
+  }
+  return begin;
+}
+
+bool ImuHistory::Validate(std::uint64_t begin) const {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  // the slot of begin is overwritten by the one of begin + capacity
+  return writing_.load(std::memory_order_relaxed) <= begin + slots_.size();
+}
+
+MYNTEYE_END_NAMESPACE
@@ -0,0 +1,83 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef MYNTEYE_DEVICE_IMU_HISTORY_H_
+#define MYNTEYE_DEVICE_IMU_HISTORY_H_
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mynteye/mynteye.h"
+#include "mynteye/types.h"
+#include "mynteye/device/callbacks.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+// Latest imu samples in a ring ordered by timestamps, pushed by one thread
+// and queried by any without lock. Readers copy optimistically and then
+// check the copied are not overwritten meanwhile, like a seqlock, and retry
+// if they are.
+class ImuHistory {
+ public:
+  // capacity is rounded up to a power of 2
+  explicit ImuHistory(std::size_t capacity);
+
+  std::size_t capacity() const {
+    return slots_.size();
+  }
+
+  // Push the samples of batch, the calibrated if has, from the one thread
+  void Push(const device::MotionBatch &batch);
+
+  // Get the samples in [t0, t1]
+  std::vector<ImuData> GetRange(std::uint64_t t0, std::uint64_t t1) const;
+
+  // Interpolate the accel and gyro at timestamp, each between the samples
+  // having it valid. Returns false if not in the history.
+  bool Interpolate(std::uint64_t timestamp, ImuData *imu) const;
+
+ private:
+  struct Slot {
+    std::uint64_t timestamp;
+    std::uint32_t frame_id;
+    std::uint8_t flag;
+    float accel[3];
+    float gyro[3];
+    float temperature;
+  };
+
+  const Slot &slot(std::uint64_t i) const {
+    return slots_[i & mask_];
+  }
+
+  // First index in [begin, end) whose timestamp >= t
+  std::uint64_t LowerBound(
+      std::uint64_t begin, std::uint64_t end, std::uint64_t t) const;
+  // Whether the indexes from begin are still valid after read
+  bool Validate(std::uint64_t begin) const;
+
+  std::vector<Slot> slots_;
+  std::uint64_t mask_;
+
+  // Count of samples pushed, the last capacity ones are in the ring
+  std::atomic<std::uint64_t> count_;
+  // Count of samples started to push, ahead of count_ while pushing
+  std::atomic<std::uint64_t> writing_;
+};
+
+MYNTEYE_END_NAMESPACE
+
+#endif  // MYNTEYE_DEVICE_IMU_HISTORY_H_
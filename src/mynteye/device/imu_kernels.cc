@@ -0,0 +1,121 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "mynteye/device/imu_kernels.h"
+
+// Imu batches are small, so use the baseline instruction set without runtime
+// dispatch, sse2 of x86_64 and neon of aarch64
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MYNTEYE_IMU_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__aarch64__)
+#define MYNTEYE_IMU_NEON
+#include <arm_neon.h>
+#endif
+
+MYNTEYE_BEGIN_NAMESPACE
+
+namespace imu {
+
+const char *isa() {
+#if defined(MYNTEYE_IMU_SSE2)
+  return "sse2";
+#elif defined(MYNTEYE_IMU_NEON)
+  return "neon";
+#else
+  return "scalar";
+#endif
+}
+
+void scale(const std::int16_t *src, float scale, float offset, float *dst,
+    std::size_t n) {
+  std::size_t i = 0;
+#if defined(MYNTEYE_IMU_SSE2)
+  const __m128 k = _mm_set1_ps(scale);
+  const __m128 b = _mm_set1_ps(offset);
+  for (; i + 8 <= n; i += 8) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    // sign extend by shifting the high halves back
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+    _mm_storeu_ps(dst + i, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(lo), k), b));
+    _mm_storeu_ps(
+        dst + i + 4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(hi), k), b));
+  }
+#elif defined(MYNTEYE_IMU_NEON)
+  const float32x4_t b = vdupq_n_f32(offset);
+  for (; i + 8 <= n; i += 8) {
+    int16x8_t v = vld1q_s16(src + i);
+    float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+    float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+    vst1q_f32(dst + i, vmlaq_n_f32(b, lo, scale));
+    vst1q_f32(dst + i + 4, vmlaq_n_f32(b, hi, scale));
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = src[i] * scale + offset;
+  }
+}
+
+void calibrate(const float *const src[3], const float scale[3][3],
+    const float drift[3], float *const dst[3], std::size_t n) {
+  std::size_t i = 0;
+#if defined(MYNTEYE_IMU_SSE2)
+  __m128 k[3][3], b[3];
+  for (int r = 0; r < 3; r++) {
+    for (int c = 0; c < 3; c++) {
+      k[r][c] = _mm_set1_ps(scale[r][c]);
+    }
+    b[r] = _mm_set1_ps(drift[r]);
+  }
+  for (; i + 4 <= n; i += 4) {
+    __m128 v[3];
+    for (int c = 0; c < 3; c++) {
+      v[c] = _mm_sub_ps(_mm_loadu_ps(src[c] + i), b[c]);
+    }
+    for (int r = 0; r < 3; r++) {
+      __m128 d = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(k[r][0], v[0]), _mm_mul_ps(k[r][1], v[1])),
+          _mm_mul_ps(k[r][2], v[2]));
+      _mm_storeu_ps(dst[r] + i, d);
+    }
+  }
+#elif defined(MYNTEYE_IMU_NEON)
+  for (; i + 4 <= n; i += 4) {
+    float32x4_t v[3];
+    for (int c = 0; c < 3; c++) {
+      v[c] = vsubq_f32(vld1q_f32(src[c] + i), vdupq_n_f32(drift[c]));
+    }
+    for (int r = 0; r < 3; r++) {
+      float32x4_t d = vmulq_n_f32(v[0], scale[r][0]);
+      d = vmlaq_n_f32(d, v[1], scale[r][1]);
+      d = vmlaq_n_f32(d, v[2], scale[r][2]);
+      vst1q_f32(dst[r] + i, d);
+    }
+  }
+#endif
+  for (; i < n; i++) {
+    float v[3];
+    for (int c = 0; c < 3; c++) {
+      v[c] = src[c][i] - drift[c];
+    }
+    for (int r = 0; r < 3; r++) {
+      dst[r][i] = scale[r][0] * v[0] + scale[r][1] * v[1] + scale[r][2] * v[2];
+    }
+  }
+}
+
+}  // namespace imu
+
+MYNTEYE_END_NAMESPACE
@@ -0,0 +1,44 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef MYNTEYE_DEVICE_IMU_KERNELS_H_
+#define MYNTEYE_DEVICE_IMU_KERNELS_H_
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mynteye/mynteye.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+// Kernels to convert imu datas of a batch, vectorized with the instruction
+// set of the build target.
+namespace imu {
+
+// Name of the instruction set used, such as "sse2"
+const char *isa();
+
+// Convert n raw values to units, dst = src * scale + offset
+void scale(const std::int16_t *src, float scale, float offset, float *dst,
+    std::size_t n);
+
+// Calibrate n 3-axis values, dst = scale * (src - drift), dst could be src
+void calibrate(const float *const src[3], const float scale[3][3],
+    const float drift[3], float *const dst[3], std::size_t n);
+
+}  // namespace imu
+
+MYNTEYE_END_NAMESPACE
+
+#endif  // MYNTEYE_DEVICE_IMU_KERNELS_H_
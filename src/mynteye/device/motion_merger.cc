@@ -0,0 +1,122 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "mynteye/device/motion_merger.h"
+
+#include <algorithm>
+
+#include "mynteye/logger.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+namespace {
+
+// Gyro samples waiting for the next accel one, dropped the oldest if more
+const std::size_t kMaxPendingGyros = 64;
+
+inline void lerp(const float *a, const float *b, float k, float *dst) {
+  for (int i = 0; i < 3; i++) {
+    dst[i] = a[i] + (b[i] - a[i]) * k;
+  }
+}
+
+}  // namespace
+
+MotionMerger::MotionMerger() : has_accel_(false), accel_() {
+  VLOG(2) << __func__;
+}
+
+void MotionMerger::Merge(
+    const device::MotionBatch &src, device::MotionBatch *dst) {
+  bool calibrated = src.calibrated();
+  std::size_t n = 0;
+  // each merged one takes a gyro sample, or a sample of both
+  dst->resize(src.size() + gyros_.size(), calibrated);
+  for (std::size_t i = 0, size = src.size(); i < size; i++) {
+    auto &&sample = Load(src, i);
+    // flag 1: accel is valid, 2: gyro is valid, 0: both
+    if (src.flag[i] == 2) {
+      if (has_accel_ && sample.timestamp == accel_.timestamp) {
+        std::copy(accel_.accel, accel_.accel + 3, sample.accel);
+        std::copy(accel_.accel_calibrated, accel_.accel_calibrated + 3,
+            sample.accel_calibrated);
+        Store(sample, dst, n++);
+      } else {
+        gyros_.push_back(sample);
+        if (gyros_.size() > kMaxPendingGyros)
+          gyros_.pop_front();
+      }
+      continue;
+    }
+
+    // interpolate the accel at the gyro ones between two accel ones
+    for (auto &&gyro : gyros_) {
+      if (!has_accel_ || gyro.timestamp < accel_.timestamp)
+        continue;
+      float k = 0;
+      if (sample.timestamp > accel_.timestamp) {
+        k = static_cast<float>(gyro.timestamp - accel_.timestamp) /
+            (sample.timestamp - accel_.timestamp);
+        if (k > 1)
+          k = 1;
+      }
+      Sample merged = gyro;
+      lerp(accel_.accel, sample.accel, k, merged.accel);
+      lerp(accel_.accel_calibrated, sample.accel_calibrated, k,
+          merged.accel_calibrated);
+      Store(merged, dst, n++);
+    }
+    gyros_.clear();
+    accel_ = sample;
+    has_accel_ = true;
+    if (src.flag[i] == 0) {
+      Store(sample, dst, n++);
+    }
+  }
+  dst->resize(n, calibrated);
+}
+
+MotionMerger::Sample MotionMerger::Load(
+    const device::MotionBatch &batch, std::size_t i) {
+  Sample sample;
+  sample.frame_id = batch.frame_id[i];
+  sample.timestamp = batch.timestamp[i];
+  sample.temperature = batch.temperature[i];
+  bool calibrated = batch.calibrated();
+  for (int j = 0; j < 3; j++) {
+    sample.accel[j] = batch.accel[j][i];
+    sample.gyro[j] = batch.gyro[j][i];
+    sample.accel_calibrated[j] = calibrated ? batch.accel_calibrated[j][i] : 0;
+    sample.gyro_calibrated[j] = calibrated ? batch.gyro_calibrated[j][i] : 0;
+  }
+  return sample;
+}
+
+void MotionMerger::Store(
+    const Sample &sample, device::MotionBatch *batch, std::size_t i) {
+  batch->frame_id[i] = sample.frame_id;
+  batch->flag[i] = 0;
+  batch->timestamp[i] = sample.timestamp;
+  batch->temperature[i] = sample.temperature;
+  bool calibrated = batch->calibrated();
+  for (int j = 0; j < 3; j++) {
+    batch->accel[j][i] = sample.accel[j];
+    batch->gyro[j][i] = sample.gyro[j];
+    if (calibrated) {
+      batch->accel_calibrated[j][i] = sample.accel_calibrated[j];
+      batch->gyro_calibrated[j][i] = sample.gyro_calibrated[j];
+    }
+  }
+}
+
+MYNTEYE_END_NAMESPACE
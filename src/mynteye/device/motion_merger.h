@@ -0,0 +1,58 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef MYNTEYE_DEVICE_MOTION_MERGER_H_
+#define MYNTEYE_DEVICE_MOTION_MERGER_H_
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+#include "mynteye/mynteye.h"
+#include "mynteye/device/callbacks.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+// Merge accel and gyro samples into 6-axis ones at the gyro timestamps, with
+// the accel interpolated linearly. Gyro samples wait for the next accel one
+// across batches. Samples of both (flag 0) pass as they are.
+class MotionMerger {
+ public:
+  MotionMerger();
+
+  // Merge the batch src to dst, which has merged ones ready only
+  void Merge(const device::MotionBatch &src, device::MotionBatch *dst);
+
+ private:
+  struct Sample {
+    std::uint32_t frame_id;
+    std::uint64_t timestamp;
+    float accel[3];
+    float gyro[3];
+    float temperature;
+    float accel_calibrated[3];
+    float gyro_calibrated[3];
+  };
+
+  static Sample Load(const device::MotionBatch &batch, std::size_t i);
+  static void Store(const Sample &sample, device::MotionBatch *batch,
+      std::size_t i);
+
+  bool has_accel_;
+  Sample accel_;
+  std::deque<Sample> gyros_;
+};
+
+MYNTEYE_END_NAMESPACE
+
+#endif  // MYNTEYE_DEVICE_MOTION_MERGER_H_
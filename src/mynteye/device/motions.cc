@@ -13,80 +13,269 @@
 // limitations under the License.
 #include "mynteye/device/motions.h"
 
+#include <atomic>
+#include <functional>
+#include <utility>
+
 #include "mynteye/logger.h"
 #include "mynteye/device/channel/channels.h"
+#include "mynteye/device/imu_history.h"
+#include "mynteye/device/imu_kernels.h"
+#include "mynteye/device/motion_merger.h"
+#include "mynteye/device/preintegrator.h"
 
 MYNTEYE_BEGIN_NAMESPACE
 
+namespace {
+
+const std::size_t kBatchPoolSize = 4;
+// Motion datas kept at most until got, as the ring preallocates its slots,
+// about 30 s at 500 Hz
+const std::size_t kMaxMotionDatasSize = 16384;
+
+}  // namespace
+
 Motions::Motions(std::shared_ptr<Channels> channels)
     : channels_(channels),
       motion_callback_(nullptr),
-      motion_datas_enabled_(false),
-      is_imu_tracking(false) {
+      motion_batch_callback_(nullptr),
+      batch_pool_(kBatchPoolSize, [](std::size_t) {
+        return std::make_shared<device::MotionBatch>();
+      }),
+      calibrated_(false),
+      merger_(nullptr),
+      preintegrator_(nullptr),
+      history_(nullptr),
+      motion_datas_(nullptr),
+      is_imu_tracking(false),
+      accel_range(0),
+      gyro_range(0) {
   CHECK_NOTNULL(channels_);
-  VLOG(2) << __func__;
+  VLOG(2) << __func__ << ", imu kernels: " << imu::isa();
+  channels_->SetImuCallback(
+      std::bind(&Motions::OnImuResPacket, this, std::placeholders::_1));
 }
 
 Motions::~Motions() {
   VLOG(2) << __func__;
+  channels_->SetImuCallback(nullptr);
 }
 
 void Motions::SetMotionCallback(motion_callback_t callback) {
-  motion_callback_ = callback;
-  if (motion_callback_) {
-    accel_range = channels_->GetControlValue(Option::ACCELEROMETER_RANGE);
-    if (accel_range == -1)
-      accel_range = channels_->GetAccelRangeDefault();
-
-    gyro_range = channels_->GetControlValue(Option::GYROSCOPE_RANGE);
-    if (gyro_range == -1)
-      gyro_range = channels_->GetGyroRangeDefault();
-
-    channels_->SetImuCallback([this](const ImuPacket &packet) {
-      if (!motion_callback_ && !motion_datas_enabled_) {
-        return;
-      }
-      for (auto &&seg : packet.segments) {
-        auto &&imu = std::make_shared<ImuData>();
-        // imu->frame_id = seg.frame_id;
-        // if (seg.offset < 0 &&
-        //     static_cast<uint32_t>(-seg.offset) > packet.timestamp) {
-        //   LOG(WARNING) << "Imu timestamp offset is incorrect";
-        // }
-        imu->frame_id = seg.frame_id;
-        imu->timestamp = seg.timestamp;
-        imu->flag = seg.flag;
-        imu->temperature = seg.temperature / 326.8f + 25;
-        imu->accel[0] = seg.accel[0] * 1.f * accel_range / 0x10000;
-        imu->accel[1] = seg.accel[1] * 1.f * accel_range / 0x10000;
-        imu->accel[2] = seg.accel[2] * 1.f * accel_range / 0x10000;
-        imu->gyro[0] = seg.gyro[0] * 1.f * gyro_range / 0x10000;
-        imu->gyro[1] = seg.gyro[1] * 1.f * gyro_range / 0x10000;
-        imu->gyro[2] = seg.gyro[2] * 1.f * gyro_range / 0x10000;
-
-        std::lock_guard<std::mutex> _(mtx_datas_);
-        motion_data_t data = {imu};
-        if (motion_datas_enabled_ && motion_datas_max_size_ > 0) {
-          if (motion_datas_.size() >= motion_datas_max_size_) {
-            motion_datas_.erase(motion_datas_.begin());
-          }
-          motion_datas_.push_back(data);
-        }
+  std::shared_ptr<const motion_callback_t> ptr = nullptr;
+  if (callback)
+    ptr = std::make_shared<const motion_callback_t>(std::move(callback));
+  std::atomic_store(&motion_callback_, ptr);
+}
 
-        motion_callback_(data);
+void Motions::SetMotionBatchCallback(motion_batch_callback_t callback) {
+  std::shared_ptr<const motion_batch_callback_t> ptr = nullptr;
+  if (callback)
+    ptr = std::make_shared<const motion_batch_callback_t>(std::move(callback));
+  std::atomic_store(&motion_batch_callback_, ptr);
+}
+
+void Motions::SetCalibration(const MotionIntrinsics *in) {
+  calibrated_ = in != nullptr;
+  if (!in)
+    return;
+  auto to_float = [](const ImuIntrinsics &from, Calibration *to) {
+    for (int r = 0; r < 3; r++) {
+      for (int c = 0; c < 3; c++) {
+        to->scale[r][c] = static_cast<float>(from.scale[r][c]);
       }
-    });
-  } else {
-    channels_->SetImuCallback(nullptr);
+      to->drift[r] = static_cast<float>(from.drift[r]);
+    }
+  };
+  to_float(in->accel, &accel_calibration_);
+  to_float(in->gyro, &gyro_calibration_);
+}
+
+void Motions::EnableMerge(bool enabled) {
+  if (enabled && !merger_) {
+    merger_ = std::make_shared<MotionMerger>();
+  } else if (!enabled) {
+    merger_ = nullptr;
+  }
+}
+
+void Motions::SetPreintegrationCallback(
+    device::ImuPreintegrationCallback callback) {
+  std::shared_ptr<Preintegrator> preintegrator = nullptr;
+  if (callback) {
+    preintegrator = std::make_shared<Preintegrator>(callback);
   }
+  std::atomic_store(&preintegrator_, preintegrator);
+}
+
+void Motions::PushFrame(const ImgData &img) {
+  auto &&preintegrator = std::atomic_load(&preintegrator_);
+  if (preintegrator) {
+    preintegrator->PushFrame(img.frame_id, img.timestamp);
+  }
+}
+
+void Motions::EnableHistory(std::size_t capacity) {
+  std::shared_ptr<ImuHistory> history = nullptr;
+  if (capacity > 0) {
+    history = std::make_shared<ImuHistory>(capacity);
+  }
+  std::atomic_store(&history_, history);
+}
+
+std::vector<ImuData> Motions::GetHistoryRange(
+    std::uint64_t t0, std::uint64_t t1) {
+  auto &&history = std::atomic_load(&history_);
+  if (!history) {
+    LOG(WARNING) << "Must enable imu history before getting its range";
+    return {};
+  }
+  return history->GetRange(t0, t1);
+}
+
+bool Motions::InterpolateHistory(std::uint64_t timestamp, ImuData *imu) {
+  auto &&history = std::atomic_load(&history_);
+  if (!history) {
+    LOG(WARNING) << "Must enable imu history before interpolating it";
+    return false;
+  }
+  return history->Interpolate(timestamp, imu);
 }
 
 void Motions::DoMotionTrack() {
+  // The imu thread polls by itself while tracking
+  if (is_imu_tracking)
+    return;
   channels_->DoImuTrack();
 }
 
+void Motions::OnImuResPacket(const ImuResPacket &res) {
+  auto &&motion_datas = std::atomic_load(&motion_datas_);
+  auto &&preintegrator = std::atomic_load(&preintegrator_);
+  auto &&history = std::atomic_load(&history_);
+  auto &&motion_callback = std::atomic_load(&motion_callback_);
+  auto &&motion_batch_callback = std::atomic_load(&motion_batch_callback_);
+  if (!motion_callback && !motion_batch_callback && !motion_datas &&
+      !preintegrator && !history) {
+    return;
+  }
+
+  std::size_t n = 0;
+  for (auto &&packet : res.packets) {
+    n += packet.segments.size();
+  }
+  if (n == 0) {
+    return;
+  }
+
+  auto batch = batch_pool_.Acquire();
+  batch->resize(n, calibrated_);
+  for (auto &&raw : raws_) {
+    raw.resize(n);
+  }
+  std::size_t i = 0;
+  for (auto &&packet : res.packets) {
+    for (auto &&seg : packet.segments) {
+      batch->frame_id[i] = seg.frame_id;
+      batch->flag[i] = seg.flag;
+      batch->timestamp[i] = seg.timestamp;
+      for (int j = 0; j < 3; j++) {
+        raws_[j][i] = seg.accel[j];
+        raws_[3 + j][i] = seg.gyro[j];
+      }
+      raws_[6][i] = seg.temperature;
+      ++i;
+    }
+  }
+  float accel_scale = accel_range * 1.f / 0x10000;
+  float gyro_scale = gyro_range * 1.f / 0x10000;
+  for (int j = 0; j < 3; j++) {
+    imu::scale(raws_[j].data(), accel_scale, 0, batch->accel[j].data(), n);
+    imu::scale(raws_[3 + j].data(), gyro_scale, 0, batch->gyro[j].data(), n);
+  }
+  imu::scale(raws_[6].data(), 1 / 326.8f, 25, batch->temperature.data(), n);
+
+  if (calibrated_) {
+    using axes_t = std::array<std::vector<float>, 3>;
+    auto calibrate = [n](const axes_t &src, const Calibration &calibration,
+        axes_t *dst) {
+      const float *src_axes[3] = {src[0].data(), src[1].data(), src[2].data()};
+      float *dst_axes[3] = {(*dst)[0].data(), (*dst)[1].data(),
+          (*dst)[2].data()};
+      imu::calibrate(
+          src_axes, calibration.scale, calibration.drift, dst_axes, n);
+    };
+    calibrate(batch->accel, accel_calibration_, &batch->accel_calibrated);
+    calibrate(batch->gyro, gyro_calibration_, &batch->gyro_calibrated);
+  }
+
+  if (merger_) {
+    auto &&merged = batch_pool_.Acquire();
+    merger_->Merge(*batch, merged.get());
+    batch = merged;
+    n = batch->size();
+    if (n == 0) {
+      return;
+    }
+  }
+
+  if (motion_callback || motion_datas) {
+    for (i = 0; i < n; i++) {
+      auto &&imu = std::make_shared<ImuData>();
+      imu->frame_id = batch->frame_id[i];
+      imu->timestamp = batch->timestamp[i];
+      imu->flag = batch->flag[i];
+      imu->temperature = batch->temperature[i];
+      for (int j = 0; j < 3; j++) {
+        imu->accel[j] = batch->accel[j][i];
+        imu->gyro[j] = batch->gyro[j][i];
+      }
+
+      std::shared_ptr<ImuData> imu_calibrated = nullptr;
+      if (calibrated_) {
+        imu_calibrated = std::make_shared<ImuData>(*imu);
+        for (int j = 0; j < 3; j++) {
+          imu_calibrated->accel[j] = batch->accel_calibrated[j][i];
+          imu_calibrated->gyro[j] = batch->gyro_calibrated[j][i];
+        }
+      }
+
+      motion_data_t data = {imu, imu_calibrated};
+      if (motion_datas) {
+        motion_datas->PushOverwrite(data);
+      }
+      if (motion_callback) {
+        (*motion_callback)(data);
+      }
+    }
+  }
+
+  if (history) {
+    history->Push(*batch);
+  }
+
+  if (preintegrator) {
+    preintegrator->Integrate(*batch);
+  }
+
+  if (motion_batch_callback) {
+    (*motion_batch_callback)(batch);
+  }
+}
+
+void Motions::UpdateRanges() {
+  accel_range = channels_->GetControlValue(Option::ACCELEROMETER_RANGE);
+  if (accel_range == -1)
+    accel_range = channels_->GetAccelRangeDefault();
+
+  gyro_range = channels_->GetControlValue(Option::GYROSCOPE_RANGE);
+  if (gyro_range == -1)
+    gyro_range = channels_->GetGyroRangeDefault();
+}
+
 void Motions::StartMotionTracking() {
   if (!is_imu_tracking) {
+    UpdateRanges();
     channels_->StartImuTracking();
     is_imu_tracking = true;
   } else {
@@ -102,10 +291,8 @@ void Motions::StopMotionTracking() {
 }
 
 void Motions::DisableMotionDatas() {
-  std::lock_guard<std::mutex> _(mtx_datas_);
-  motion_datas_enabled_ = false;
-  motion_datas_max_size_ = 0;
-  motion_datas_.clear();
+  std::atomic_store(
+      &motion_datas_, std::shared_ptr<motion_datas_ring_t>(nullptr));
 }
 
 void Motions::EnableMotionDatas(std::size_t max_size) {
@@ -113,19 +300,30 @@ void Motions::EnableMotionDatas(std::size_t max_size) {
     LOG(WARNING) << "Could not enable motion datas with max_size <= 0";
     return;
   }
-  std::lock_guard<std::mutex> _(mtx_datas_);
-  motion_datas_enabled_ = true;
-  motion_datas_max_size_ = max_size;
+  if (max_size > kMaxMotionDatasSize) {
+    VLOG(2) << "Motion datas max_size " << max_size << " is limited to "
+            << kMaxMotionDatasSize;
+    max_size = kMaxMotionDatasSize;
+  }
+  auto &&motion_datas = std::atomic_load(&motion_datas_);
+  if (motion_datas && motion_datas->capacity() == max_size)
+    return;
+  std::atomic_store(
+      &motion_datas_, std::make_shared<motion_datas_ring_t>(max_size));
 }
 
 Motions::motion_datas_t Motions::GetMotionDatas() {
-  if (!motion_datas_enabled_) {
+  auto &&motion_datas = std::atomic_load(&motion_datas_);
+  if (!motion_datas) {
     LOG(FATAL) << "Must enable motion datas before getting them, or you set "
                   "motion callback instead";
   }
-  std::lock_guard<std::mutex> _(mtx_datas_);
-  motion_datas_t datas = motion_datas_;
-  motion_datas_.clear();
+  motion_datas_t datas;
+  datas.reserve(motion_datas->size());
+  motion_data_t data;
+  while (motion_datas->TryPop(&data)) {
+    datas.push_back(std::move(data));
+  }
   return datas;
 }
 
@@ -15,16 +15,24 @@
 #define MYNTEYE_DEVICE_MOTIONS_H_
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
-#include <mutex>
 #include <vector>
 
 #include "mynteye/mynteye.h"
 #include "mynteye/device/callbacks.h"
+#include "mynteye/util/object_pool.h"
+#include "mynteye/util/ring_buffer.h"
 
 MYNTEYE_BEGIN_NAMESPACE
 
 class Channels;
+class ImuHistory;
+class MotionMerger;
+class Preintegrator;
+struct ImuResPacket;
 
 class Motions {
  public:
@@ -32,13 +40,34 @@ class Motions {
   using motion_datas_t = std::vector<motion_data_t>;
 
   using motion_callback_t = device::MotionCallback;
+  using motion_batch_callback_t = device::MotionBatchCallback;
 
   explicit Motions(std::shared_ptr<Channels> channels);
   ~Motions();
 
   void SetMotionCallback(motion_callback_t callback);
+  void SetMotionBatchCallback(motion_batch_callback_t callback);
   void DoMotionTrack();
 
+  // Calibrate motion datas by the intrinsics, or not if null
+  void SetCalibration(const MotionIntrinsics *in);
+
+  // Merge accel and gyro into 6-axis motion datas at the gyro timestamps
+  void EnableMerge(bool enabled);
+
+  // Preintegrate motion datas between left frames, or not if null
+  void SetPreintegrationCallback(
+      device::ImuPreintegrationCallback callback);
+  // Push the left frame to preintegrate to, from the capture thread
+  void PushFrame(const ImgData &img);
+
+  // Keep the latest motion datas by time to query, or not if 0
+  void EnableHistory(std::size_t capacity);
+  // Get the motion datas in [t0, t1] of the history
+  std::vector<ImuData> GetHistoryRange(std::uint64_t t0, std::uint64_t t1);
+  // Interpolate the motion data at timestamp of the history
+  bool InterpolateHistory(std::uint64_t timestamp, ImuData *imu);
+
   void StartMotionTracking();
   void StopMotionTracking();
 
@@ -47,17 +76,46 @@ class Motions {
   motion_datas_t GetMotionDatas();
 
  private:
-  std::shared_ptr<Channels> channels_;
-
-  motion_callback_t motion_callback_;
+  void OnImuResPacket(const ImuResPacket &res);
+  void UpdateRanges();
 
-  motion_datas_t motion_datas_;
-  bool motion_datas_enabled_;
-  std::size_t motion_datas_max_size_;
-
-  bool is_imu_tracking;
+  std::shared_ptr<Channels> channels_;
 
-  std::mutex mtx_datas_;
+  // Replaced while tracking, so read by the imu thread as snapshots, nullptr
+  // if not set
+  std::shared_ptr<const motion_callback_t> motion_callback_;
+  std::shared_ptr<const motion_batch_callback_t> motion_batch_callback_;
+
+  // Batches of each imu read, reused once the callback released them
+  ObjectPool<device::MotionBatch> batch_pool_;
+  // Raw accel, gyro and temperature values of a batch, to convert at once
+  std::array<std::vector<std::int16_t>, 7> raws_;
+
+  // Scale and drift in float, to calibrate batches
+  struct Calibration {
+    float scale[3][3];
+    float drift[3];
+  };
+  bool calibrated_;
+  Calibration accel_calibration_;
+  Calibration gyro_calibration_;
+
+  // Only for the imu thread, set before tracking, nullptr if disabled
+  std::shared_ptr<MotionMerger> merger_;
+
+  // Read by the capture and imu threads without lock, nullptr if disabled
+  std::shared_ptr<Preintegrator> preintegrator_;
+
+  // Pushed by the imu thread and read by any without lock, nullptr if
+  // disabled
+  std::shared_ptr<ImuHistory> history_;
+
+  // Pushed by the imu thread without lock, nullptr if disabled
+  using motion_datas_ring_t = RingBuffer<motion_data_t>;
+  std::shared_ptr<motion_datas_ring_t> motion_datas_;
+
+  // Read by the capture thread in DoMotionTrack()
+  std::atomic<bool> is_imu_tracking;
 
   int accel_range;
   int gyro_range;
@@ -0,0 +1,179 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "mynteye/device/preintegrator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "mynteye/logger.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+namespace {
+
+const double kGravity = 9.80665;  // m/s^2 of 1 g
+const double kDegToRad = 3.14159265358979323846 / 180;
+
+// Frames pushed but not integrated yet, dropped the oldest if more
+const std::size_t kFramesCapacity = 32;
+// Samples held without frames, as video is not streaming, dropped if more
+const std::size_t kMaxPendingSamples = 4096;
+// Frames held without samples reaching them, as imu stalls or its timestamp
+// wraps, dropped the oldest if more
+const std::size_t kMaxPendingFrames = 64;
+
+// Rotation of the rotation vector, by the Rodrigues' formula
+void rotation_exp(const double phi[3], double r[3][3]) {
+  double theta = std::sqrt(phi[0] * phi[0] + phi[1] * phi[1] + phi[2] * phi[2]);
+  double k[3][3] = {
+      {0, -phi[2], phi[1]}, {phi[2], 0, -phi[0]}, {-phi[1], phi[0], 0}};
+  double a, b;
+  if (theta < 1e-8) {
+    a = 1;
+    b = 0.5;
+  } else {
+    a = std::sin(theta) / theta;
+    b = (1 - std::cos(theta)) / (theta * theta);
+  }
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      double kk = 0;
+      for (int m = 0; m < 3; m++) {
+        kk += k[i][m] * k[m][j];
+      }
+      r[i][j] = (i == j ? 1 : 0) + a * k[i][j] + b * kk;
+    }
+  }
+}
+
+}  // namespace
+
+Preintegrator::Preintegrator(callback_t callback)
+    : callback_(std::move(callback)),
+      frames_(kFramesCapacity),
+      timestamp_(0),
+      accel_{0, 0, 0},
+      gyro_{0, 0, 0},
+      started_(false) {
+  VLOG(2) << __func__;
+}
+
+void Preintegrator::PushFrame(std::uint16_t frame_id, std::uint64_t timestamp) {
+  frames_.PushOverwrite({frame_id, timestamp});
+}
+
+void Preintegrator::Integrate(const device::MotionBatch &batch) {
+  auto &&accel = batch.calibrated() ? batch.accel_calibrated : batch.accel;
+  auto &&gyro = batch.calibrated() ? batch.gyro_calibrated : batch.gyro;
+  for (std::size_t i = 0, n = batch.size(); i < n; i++) {
+    Sample sample;
+    sample.timestamp = batch.timestamp[i];
+    sample.flag = batch.flag[i];
+    for (int j = 0; j < 3; j++) {
+      sample.accel[j] = accel[j][i] * kGravity;
+      sample.gyro[j] = gyro[j][i] * kDegToRad;
+    }
+    pending_samples_.push_back(sample);
+  }
+  while (pending_samples_.size() > kMaxPendingSamples) {
+    pending_samples_.pop_front();
+  }
+
+  Frame pushed;
+  while (frames_.TryPop(&pushed)) {
+    pending_frames_.push_back(pushed);
+  }
+  while (pending_frames_.size() > kMaxPendingFrames) {
+    pending_frames_.pop_front();
+  }
+
+  while (!pending_frames_.empty()) {
+    auto &&frame = pending_frames_.front();
+    // wait until the samples reach the frame
+    if (pending_samples_.empty() ||
+        pending_samples_.back().timestamp < frame.timestamp) {
+      break;
+    }
+    while (!pending_samples_.empty() &&
+        pending_samples_.front().timestamp <= frame.timestamp) {
+      auto &&sample = pending_samples_.front();
+      Step(sample.timestamp);
+      Hold(sample);
+      if (started_)
+        ++current_.count;
+      pending_samples_.pop_front();
+    }
+    Finish(frame);
+    pending_frames_.pop_front();
+  }
+}
+
+void Preintegrator::Step(std::uint64_t timestamp) {
+  if (timestamp_ == 0 || timestamp <= timestamp_) {
+    if (timestamp > timestamp_)
+      timestamp_ = timestamp;
+    return;
+  }
+  if (started_) {
+    double dt = (timestamp - timestamp_) * 1e-6;
+    auto &&r = current_.delta_rotation;
+    auto &&v = current_.delta_velocity;
+    auto &&p = current_.delta_position;
+    double a[3];
+    for (int i = 0; i < 3; i++) {
+      a[i] = r[i][0] * accel_[0] + r[i][1] * accel_[1] + r[i][2] * accel_[2];
+    }
+    for (int i = 0; i < 3; i++) {
+      p[i] += v[i] * dt + 0.5 * a[i] * dt * dt;
+      v[i] += a[i] * dt;
+    }
+    double phi[3] = {gyro_[0] * dt, gyro_[1] * dt, gyro_[2] * dt};
+    double dr[3][3];
+    rotation_exp(phi, dr);
+    double rr[3][3];
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 3; j++) {
+        rr[i][j] = r[i][0] * dr[0][j] + r[i][1] * dr[1][j] + r[i][2] * dr[2][j];
+      }
+    }
+    std::copy(&rr[0][0], &rr[0][0] + 9, &r[0][0]);
+  }
+  timestamp_ = timestamp;
+}
+
+void Preintegrator::Hold(const Sample &sample) {
+  // flag 1: accel is valid, 2: gyro is valid, 0: both
+  if (sample.flag != 2) {
+    std::copy(sample.accel, sample.accel + 3, accel_);
+  }
+  if (sample.flag != 1) {
+    std::copy(sample.gyro, sample.gyro + 3, gyro_);
+  }
+}
+
+void Preintegrator::Finish(const Frame &frame) {
+  Step(frame.timestamp);
+  if (started_) {
+    current_.frame_id = frame.frame_id;
+    current_.end_timestamp = frame.timestamp;
+    if (callback_)
+      callback_(current_);
+  }
+  current_ = {};
+  current_.begin_timestamp = frame.timestamp;
+  started_ = true;
+}
+
+MYNTEYE_END_NAMESPACE
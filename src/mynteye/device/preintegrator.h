@@ -0,0 +1,79 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef MYNTEYE_DEVICE_PREINTEGRATOR_H_
+#define MYNTEYE_DEVICE_PREINTEGRATOR_H_
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+#include "mynteye/mynteye.h"
+#include "mynteye/device/callbacks.h"
+#include "mynteye/util/ring_buffer.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+// Preintegrate imu datas between left frames. Frames are pushed by the
+// capture thread, batches are integrated by the imu thread. Samples newer
+// than the frames known are held until their frame comes, as frames may come
+// later than the imu datas of their time.
+class Preintegrator {
+ public:
+  using callback_t = device::ImuPreintegrationCallback;
+
+  explicit Preintegrator(callback_t callback);
+
+  // Push the timestamp of a left frame, from the capture thread
+  void PushFrame(std::uint16_t frame_id, std::uint64_t timestamp);
+
+  // Integrate a batch, the calibrated datas if has, from the imu thread
+  void Integrate(const device::MotionBatch &batch);
+
+ private:
+  struct Frame {
+    std::uint16_t frame_id;
+    std::uint64_t timestamp;
+  };
+
+  struct Sample {
+    std::uint64_t timestamp;
+    std::uint8_t flag;
+    double accel[3];  // m/s^2
+    double gyro[3];   // rad/s
+  };
+
+  void Step(std::uint64_t timestamp);
+  void Hold(const Sample &sample);
+  void Finish(const Frame &frame);
+
+  callback_t callback_;
+
+  RingBuffer<Frame> frames_;
+  std::deque<Frame> pending_frames_;
+  std::deque<Sample> pending_samples_;
+
+  // Last sample integrated, and its values held until the next one
+  std::uint64_t timestamp_;
+  double accel_[3];
+  double gyro_[3];
+
+  // Integrated since the last frame, started from the first frame
+  bool started_;
+  device::ImuPreintegration current_;
+};
+
+MYNTEYE_END_NAMESPACE
+
+#endif  // MYNTEYE_DEVICE_PREINTEGRATOR_H_
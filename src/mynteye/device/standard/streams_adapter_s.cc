@@ -17,6 +17,7 @@
 
 #include "mynteye/logger.h"
 #include "mynteye/device/types.h"
+#include "mynteye/device/unpack.h"
 
 MYNTEYE_BEGIN_NAMESPACE
 
@@ -109,9 +110,7 @@ bool unpack_left_img_pixels(
   CHECK_EQ(frame->format(), Format::GREY);
   auto data_new = reinterpret_cast<const std::uint8_t *>(data);
   std::size_t n = frame->width() * frame->height();
-  for (std::size_t i = 0; i < n; i++) {
-    frame->data()[i] = *(data_new + (i * 2));
-  }
+  unpack::pick(data_new, frame->data(), n, 0);
   return true;
 }
 
@@ -122,9 +121,23 @@ bool unpack_right_img_pixels(
   CHECK_EQ(frame->format(), Format::GREY);
   auto data_new = reinterpret_cast<const std::uint8_t *>(data);
   std::size_t n = frame->width() * frame->height();
-  for (std::size_t i = 0; i < n; i++) {
-    frame->data()[i] = *(data_new + (i * 2 + 1));
-  }
+  unpack::pick(data_new, frame->data(), n, 1);
+  return true;
+}
+
+// left and right pixels are interleaved byte by byte
+
+bool unpack_stereo_img_pixels(
+    const void *data, const StreamRequest &request, std::size_t row_beg,
+    std::size_t row_end, Streams::frame_t *left, Streams::frame_t *right) {
+  CHECK_EQ(request.format, Format::YUYV);
+  CHECK_EQ(left->format(), Format::GREY);
+  CHECK_EQ(right->format(), Format::GREY);
+  auto data_new = reinterpret_cast<const std::uint8_t *>(data);
+  std::size_t w = left->width();
+  std::size_t beg = row_beg * w;
+  unpack::deinterleave(data_new + beg * 2, left->data() + beg,
+      right->data() + beg, (row_end - row_beg) * w);
   return true;
 }
 
@@ -160,4 +173,9 @@ StandardStreamsAdapter::GetUnpackImgPixelsMap() {
   };
 }
 
+Streams::unpack_stereo_img_pixels_t
+StandardStreamsAdapter::GetUnpackStereoImgPixels() {
+  return unpack_stereo_img_pixels;
+}
+
 MYNTEYE_END_NAMESPACE
@@ -35,6 +35,7 @@ class StandardStreamsAdapter : public StreamsAdapter {
   GetUnpackImgDataMap() override;
   std::map<Stream, Streams::unpack_img_pixels_t>
   GetUnpackImgPixelsMap() override;
+  Streams::unpack_stereo_img_pixels_t GetUnpackStereoImgPixels() override;
 };
 
 MYNTEYE_END_NAMESPACE
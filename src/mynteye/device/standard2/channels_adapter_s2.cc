@@ -118,4 +118,10 @@ void Standard2ChannelsAdapter::GetImuResPacket(
   unpack_imu_res_packet(data, res);
 }
 
+std::uint32_t Standard2ChannelsAdapter::GetImuSerialSpan(
+    const ImuPacket &packet) {
+  // Serial number of packet is the frame id of its last segment
+  return packet.count;
+}
+
 MYNTEYE_END_NAMESPACE
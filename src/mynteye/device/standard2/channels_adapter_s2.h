@@ -35,6 +35,7 @@ class Standard2ChannelsAdapter : public ChannelsAdapter {
   std::vector<std::int32_t> GetGyroRangeValues() override;
 
   void GetImuResPacket(const std::uint8_t *data, ImuResPacket *res) override;
+  std::uint32_t GetImuSerialSpan(const ImuPacket &packet) override;
 };
 
 MYNTEYE_END_NAMESPACE
@@ -13,10 +13,12 @@
 // limitations under the License.
 #include "mynteye/device/standard2/streams_adapter_s2.h"
 
+#include <algorithm>
 #include <iomanip>
 
 #include "mynteye/logger.h"
 #include "mynteye/device/types.h"
+#include "mynteye/device/unpack.h"
 
 MYNTEYE_BEGIN_NAMESPACE
 
@@ -58,19 +60,27 @@ struct ImagePacket {
 
 // image pixels
 
+// the row of frame from the yuyv row, copy or pick the luma if grey
+void unpack_row(const std::uint8_t *src, Streams::frame_t *frame,
+    std::size_t i) {
+  std::size_t w = frame->width();
+  if (frame->format() == Format::GREY) {
+    unpack::pick(src, frame->data() + i * frame->step(), w, 0);
+  } else {
+    std::copy(src, src + 2 * w, frame->data() + i * frame->step());
+  }
+}
+
 bool unpack_left_img_pixels(
     const void *data, const StreamRequest &request, Streams::frame_t *frame) {
   CHECK_NOTNULL(frame);
   CHECK_EQ(request.format, Format::YUYV);
-  CHECK_EQ(frame->format(), Format::YUYV);
+  CHECK(frame->format() == Format::YUYV || frame->format() == Format::GREY);
   auto data_new = reinterpret_cast<const std::uint8_t *>(data);
-  std::size_t n = 2;
-  std::size_t w = frame->width() * n;
+  std::size_t w = frame->width() * 2;
   std::size_t h = frame->height();
   for (std::size_t i = 0; i < h; i++) {
-    for (std::size_t j = 0; j < w; j++) {
-      frame->data()[i * w + j] = *(data_new + 2 * i * w + j);
-    }
+    unpack_row(data_new + 2 * i * w, frame, i);
   }
   return true;
 }
@@ -79,19 +89,56 @@ bool unpack_right_img_pixels(
     const void *data, const StreamRequest &request, Streams::frame_t *frame) {
   CHECK_NOTNULL(frame);
   CHECK_EQ(request.format, Format::YUYV);
-  CHECK_EQ(frame->format(), Format::YUYV);
+  CHECK(frame->format() == Format::YUYV || frame->format() == Format::GREY);
   auto data_new = reinterpret_cast<const std::uint8_t *>(data);
-  std::size_t n = 2;
-  std::size_t w = frame->width() * n;
+  std::size_t w = frame->width() * 2;
   std::size_t h = frame->height();
   for (std::size_t i = 0; i < h; i++) {
-    for (std::size_t j = 0; j < w; j++) {
-      frame->data()[i * w + j] = *(data_new + (2 * i + 1) * w + j);
-    }
+    unpack_row(data_new + (2 * i + 1) * w, frame, i);
+  }
+  return true;
+}
+
+bool unpack_stereo_img_pixels(
+    const void *data, const StreamRequest &request, std::size_t row_beg,
+    std::size_t row_end, Streams::frame_t *left, Streams::frame_t *right) {
+  CHECK_EQ(request.format, Format::YUYV);
+  CHECK(left->format() == Format::YUYV || left->format() == Format::GREY);
+  CHECK_EQ(left->format(), right->format());
+  auto data_new = reinterpret_cast<const std::uint8_t *>(data);
+  std::size_t w = left->width() * 2;
+  for (std::size_t i = row_beg; i < row_end; i++) {
+    auto &&row = data_new + 2 * i * w;
+    unpack_row(row, left, i);
+    unpack_row(row + w, right, i);
   }
   return true;
 }
 
+// left and right rows are interleaved, view them with double step
+
+bool view_left_img_pixels(
+    const void *data, const StreamRequest &request,
+    std::uint8_t **pixels, std::size_t *step) {
+  CHECK_EQ(request.format, Format::YUYV);
+  std::size_t w = request.width / 2 * bytes_per_pixel(request.format);
+  *pixels = const_cast<std::uint8_t *>(
+      reinterpret_cast<const std::uint8_t *>(data));
+  *step = 2 * w;
+  return true;
+}
+
+bool view_right_img_pixels(
+    const void *data, const StreamRequest &request,
+    std::uint8_t **pixels, std::size_t *step) {
+  CHECK_EQ(request.format, Format::YUYV);
+  std::size_t w = request.width / 2 * bytes_per_pixel(request.format);
+  *pixels = const_cast<std::uint8_t *>(
+      reinterpret_cast<const std::uint8_t *>(data)) + w;
+  *step = 2 * w;
+  return true;
+}
+
 bool unpack_stereo_img_data(
     const void *data, const StreamRequest &request, ImgData *img) {
   CHECK_NOTNULL(img);
@@ -173,4 +220,17 @@ Standard2StreamsAdapter::GetUnpackImgPixelsMap() {
   };
 }
 
+Streams::unpack_stereo_img_pixels_t
+Standard2StreamsAdapter::GetUnpackStereoImgPixels() {
+  return unpack_stereo_img_pixels;
+}
+
+std::map<Stream, Streams::view_img_pixels_t>
+Standard2StreamsAdapter::GetViewImgPixelsMap() {
+  return {
+    {Stream::LEFT, view_left_img_pixels},
+    {Stream::RIGHT, view_right_img_pixels}
+  };
+}
+
 MYNTEYE_END_NAMESPACE
@@ -35,6 +35,9 @@ class Standard2StreamsAdapter : public StreamsAdapter {
   GetUnpackImgDataMap() override;
   std::map<Stream, Streams::unpack_img_pixels_t>
   GetUnpackImgPixelsMap() override;
+  Streams::unpack_stereo_img_pixels_t GetUnpackStereoImgPixels() override;
+  std::map<Stream, Streams::view_img_pixels_t>
+  GetViewImgPixelsMap() override;
 };
 
 MYNTEYE_END_NAMESPACE
@@ -17,6 +17,7 @@
 
 #include "mynteye/logger.h"
 #include "mynteye/device/types.h"
+#include "mynteye/device/unpack.h"
 
 MYNTEYE_BEGIN_NAMESPACE
 
@@ -68,14 +69,7 @@ bool unpack_left_img_pixels(
   std::size_t w = frame->width();
   std::size_t h = frame->height();
   for (std::size_t i = 0; i < h; i++) {
-    for (std::size_t j = 0; j < w; j++) {
-      frame->data()[(i * w + j) * n] =
-        *(data_new + (2 * i * w + j) * n + 2);
-      frame->data()[(i * w + j) * n + 1] =
-        *(data_new + (2 * i * w + j) * n + 1);
-      frame->data()[(i * w + j) * n + 2] =
-        *(data_new + (2 * i * w + j) * n);
-    }
+    unpack::swap_rb(data_new + 2 * i * w * n, frame->data() + i * w * n, w);
   }
   return true;
 }
@@ -90,14 +84,25 @@ bool unpack_right_img_pixels(
   std::size_t w = frame->width();
   std::size_t h = frame->height();
   for (std::size_t i = 0; i < h; i++) {
-    for (std::size_t j = 0; j < w; j++) {
-      frame->data()[(i * w + j) * n] =
-        *(data_new + ((2 * i + 1) * w + j) * n + 2);
-      frame->data()[(i * w + j) * n + 1] =
-        *(data_new + ((2 * i + 1) * w + j) * n + 1);
-      frame->data()[(i * w + j) * n + 2] =
-        *(data_new + ((2 * i + 1) * w + j) * n);
-    }
+    unpack::swap_rb(
+        data_new + (2 * i + 1) * w * n, frame->data() + i * w * n, w);
+  }
+  return true;
+}
+
+bool unpack_stereo_img_pixels(
+    const void *data, const StreamRequest &request, std::size_t row_beg,
+    std::size_t row_end, Streams::frame_t *left, Streams::frame_t *right) {
+  CHECK_EQ(request.format, Format::BGR888);
+  CHECK_EQ(left->format(), Format::BGR888);
+  CHECK_EQ(right->format(), Format::BGR888);
+  auto data_new = reinterpret_cast<const std::uint8_t *>(data);
+  std::size_t n = 3;
+  std::size_t w = left->width();
+  for (std::size_t i = row_beg; i < row_end; i++) {
+    auto &&row = data_new + 2 * i * w * n;
+    unpack::swap_rb(row, left->data() + i * w * n, w);
+    unpack::swap_rb(row + w * n, right->data() + i * w * n, w);
   }
   return true;
 }
@@ -183,4 +188,9 @@ Standard210aStreamsAdapter::GetUnpackImgPixelsMap() {
   };
 }
 
+Streams::unpack_stereo_img_pixels_t
+Standard210aStreamsAdapter::GetUnpackStereoImgPixels() {
+  return unpack_stereo_img_pixels;
+}
+
 MYNTEYE_END_NAMESPACE
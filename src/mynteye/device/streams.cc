@@ -15,7 +15,6 @@
 
 #include <algorithm>
 #include <chrono>
-#include <stdexcept>
 
 #include "mynteye/logger.h"
 #include "mynteye/device/types.h"
@@ -25,9 +24,21 @@ MYNTEYE_BEGIN_NAMESPACE
 Streams::Streams(const std::shared_ptr<StreamsAdapter> &adapter)
     : key_streams_(std::move(adapter->GetKeyStreams())),
       stream_capabilities_(std::move(adapter->GetStreamCapabilities())),
-      unpack_img_data_map_(std::move(adapter->GetUnpackImgDataMap())),
-      unpack_img_pixels_map_(std::move(adapter->GetUnpackImgPixelsMap())) {
+      unpack_img_data_map_(adapter->GetUnpackImgDataMap()),
+      unpack_img_pixels_map_(adapter->GetUnpackImgPixelsMap()),
+      view_img_pixels_map_(adapter->GetViewImgPixelsMap()),
+      unpack_stereo_img_pixels_(adapter->GetUnpackStereoImgPixels()),
+      unpack_worker_(nullptr),
+      luma_only_(false),
+      img_stats_enabled_(false),
+      frame_pool_size_(0) {
   VLOG(2) << __func__;
+  for (auto &&it : unpack_img_pixels_map_) {
+    stream_datas_map_[it.first] = std::make_shared<stream_datas_ring_t>(
+        GetStreamDataMaxSize(it.first));
+    callback_demands_map_[it.first] = false;
+    consumer_demands_map_[it.first] = false;
+  }
 }
 
 Streams::~Streams() {
@@ -42,39 +53,79 @@ void Streams::ConfigStream(
   }
   VLOG(2) << "Config stream request of " << capability << ", " << request;
   stream_config_requests_[capability] = request;
+  ResetFramePools();
 }
 
 bool Streams::PushStream(const Capabilities &capability, const void *data) {
+  return PushStream(capability, data, uvc::frame_info(), nullptr);
+}
+
+bool Streams::PushStream(const Capabilities &capability, const void *data,
+    const uvc::frame_info &info, std::shared_ptr<void> holder) {
   if (!HasStreamConfigRequest(capability)) {
     LOG(FATAL) << "Cannot push stream without stream config request";
   }
-  std::unique_lock<std::mutex> lock(mtx_);
   auto &&request = GetStreamConfigRequest(capability);
   bool pushed = false;
   switch (capability) {
     case Capabilities::STEREO:
     case Capabilities::STEREO_COLOR: {
-      // alloc left
-      AllocStreamData(capability, Stream::LEFT, request);
-      auto &&left_data = stream_datas_map_[Stream::LEFT].back();
-      // unpack img data
-      if (unpack_img_data_map_[Stream::LEFT](
-              data, request, left_data.img.get())) {
-        left_data.frame_id = left_data.img->frame_id;
-        // alloc right
-        AllocStreamData(capability, Stream::RIGHT, request);
-        auto &&right_data = stream_datas_map_[Stream::RIGHT].back();
-        *right_data.img = *left_data.img;
-        right_data.frame_id = left_data.img->frame_id;
-        // unpack frame
-        unpack_img_pixels_map_[Stream::LEFT](
-            data, request, left_data.frame.get());
-        unpack_img_pixels_map_[Stream::RIGHT](
-            data, request, right_data.frame.get());
+      bool demand_left = IsStreamDemanded(Stream::LEFT);
+      bool demand_right = IsStreamDemanded(Stream::RIGHT);
+      // the luma only is unpacked, could not be viewed
+      bool view = holder && GetFrameFormat(capability, request) ==
+          request.format;
+      bool view_left = view && view_img_pixels_map_.count(Stream::LEFT);
+      bool view_right = view && view_img_pixels_map_.count(Stream::RIGHT);
+      // unpack img data, always to accept or drop the packet
+      ImgData img;
+      if (unpack_img_data_map_[Stream::LEFT](data, request, &img)) {
+        img.capture_timestamp = info.timestamp;
+        img.capture_sequence = info.sequence;
+        img.dequeue_timestamp = info.dequeue_timestamp;
+        pushed_img_ = img;
+        // alloc the demanded ones
+        stream_data_t left_data, right_data;
+        if (demand_left) {
+          left_data =
+              AllocStreamData(capability, Stream::LEFT, request, !view_left);
+          *left_data.img = img;
+          left_data.frame_id = img.frame_id;
+        }
+        if (demand_right) {
+          right_data =
+              AllocStreamData(capability, Stream::RIGHT, request, !view_right);
+          *right_data.img = img;
+          right_data.frame_id = img.frame_id;
+        }
+        // view or unpack frame
+        if (demand_left && demand_right && !view_left && !view_right &&
+            unpack_stereo_img_pixels_) {
+          UnpackStereoFrames(
+              data, request, left_data.frame.get(), right_data.frame.get(),
+              left_data.stats.get(), right_data.stats.get());
+        } else {
+          if (demand_left && (!view_left || !ViewStreamFrame(capability,
+                  Stream::LEFT, request, data, holder, &left_data.frame))) {
+            unpack_img_pixels_map_[Stream::LEFT](
+                data, request, left_data.frame.get());
+          }
+          if (demand_right && (!view_right || !ViewStreamFrame(capability,
+                  Stream::RIGHT, request, data, holder, &right_data.frame))) {
+            unpack_img_pixels_map_[Stream::RIGHT](
+                data, request, right_data.frame.get());
+          }
+          if (left_data.stats)
+            ComputeImgStats(*left_data.frame, left_data.stats.get());
+          if (right_data.stats)
+            ComputeImgStats(*right_data.frame, right_data.stats.get());
+        }
+        if (demand_left)
+          PushStreamData(Stream::LEFT, left_data);
+        if (demand_right)
+          PushStreamData(Stream::RIGHT, right_data);
         pushed = true;
       } else {
-        // discard left
-        DiscardStreamData(Stream::LEFT);
         VLOG(2) << "Image packet is unaccepted, frame dropped";
         pushed = false;
       }
@@ -82,8 +133,11 @@ bool Streams::PushStream(const Capabilities &capability, const void *data) {
     default:
       LOG(FATAL) << "Not supported " << capability << " now";
   }
-  if (HasKeyStreamDatas())
+  if (pushed && HasKeyStreamDatas()) {
+    // Lock only to not miss the waiting one
+    { std::lock_guard<std::mutex> _(mtx_); }
     cv_.notify_one();
+  }
   return pushed;
 }
 
@@ -96,53 +150,140 @@ void Streams::WaitForStreams() {
   }
 }
 
+void Streams::EnableParallelUnpack(bool enabled) {
+  if (enabled && !unpack_worker_) {
+    unpack_worker_ = std::make_shared<unpack::Worker>();
+  } else if (!enabled) {
+    unpack_worker_ = nullptr;
+  }
+}
+
+void Streams::SetStreamDemanded(const Stream &stream, bool demanded) {
+  auto &&demand = callback_demands_map_.find(stream);
+  if (demand) {
+    *demand = demanded;
+  }
+}
+
+bool Streams::IsStreamDemanded(const Stream &stream) const {
+  auto &&demand = callback_demands_map_.find(stream);
+  if (!demand)
+    return false;
+  if (*demand || consumer_demands_map_.at(stream))
+    return true;
+  // none demanded, all are
+  for (auto &&it : callback_demands_map_) {
+    if (it.second || consumer_demands_map_.at(it.first))
+      return false;
+  }
+  return true;
+}
+
+void Streams::EnableLumaOnly(bool enabled) {
+  luma_only_ = enabled;
+  ResetFramePools();
+}
+
+void Streams::EnableImgStats(bool enabled) {
+  img_stats_enabled_ = enabled;
+  ResetFramePools();
+}
+
 void Streams::ConfigStreamLimits(
     const Stream &stream, std::size_t max_data_size) {
   CHECK_GT(max_data_size, 0);
   stream_limits_map_[stream] = max_data_size;
+  if (stream_datas_map_.count(stream)) {
+    stream_datas_map_[stream] =
+        std::make_shared<stream_datas_ring_t>(max_data_size);
+    ResetFramePools();
+  }
 }
 
 std::size_t Streams::GetStreamDataMaxSize(const Stream &stream) const {
-  try {
-    return stream_limits_map_.at(stream);
-  } catch (const std::out_of_range &e) {
-    return 4;  // default stream data max size
+  auto &&limit = stream_limits_map_.find(stream);
+  return limit ? *limit : 4;  // default stream data max size
+}
+
+void Streams::ConfigFramePool(std::size_t size) {
+  frame_pool_size_ = size;
+  ResetFramePools();
+}
+
+std::size_t Streams::GetFramePoolSize(const Stream &stream) const {
+  if (frame_pool_size_ > 0)
+    return frame_pool_size_;
+  // the ring, the one pushed, and the ones called back or got
+  return GetStreamDataMaxSize(stream) + 4;
+}
+
+void Streams::GetFramePoolStats(
+    std::uint64_t *hits, std::uint64_t *misses) const {
+  *hits = 0;
+  *misses = 0;
+  for (auto &&it : frame_pools_map_) {
+    *hits += it.second->hits();
+    *misses += it.second->misses();
+  }
+}
+
+void Streams::ResetFramePoolStats() {
+  for (auto &&it : frame_pools_map_) {
+    it.second->ResetStats();
   }
 }
 
 Streams::stream_datas_t Streams::GetStreamDatas(const Stream &stream) {
-  std::unique_lock<std::mutex> lock(mtx_);
+  auto &&demand = consumer_demands_map_.find(stream);
+  if (demand && !*demand) {
+    // demanded from now on, pushed without it before
+    *demand = true;
+  }
   if (!HasStreamDatas(stream)) {
     LOG(WARNING) << "There are no stream datas of " << stream
                  << ". Did you call WaitForStreams() before this?";
     return {};
   }
-  auto datas = stream_datas_map_.at(stream);
-  stream_datas_map_[stream].clear();
+  auto &&ring = stream_datas_map_[stream];
+  stream_datas_t datas;
+  datas.reserve(ring->capacity());
+  stream_data_t data;
+  while (ring->TryPop(&data)) {
+    datas.push_back(std::move(data));
+  }
   return datas;
 }
 
 Streams::stream_data_t Streams::GetLatestStreamData(const Stream &stream) {
-  std::unique_lock<std::mutex> lock(mtx_);
+  auto &&demand = consumer_demands_map_.find(stream);
+  if (demand && !*demand) {
+    // demanded from now on, pushed without it before
+    *demand = true;
+  }
   if (!HasStreamDatas(stream)) {
     LOG(WARNING) << "There are no stream datas of " << stream
                  << ". Did you call WaitForStreams() before this?";
     return {};
   }
-  auto data = stream_datas_map_.at(stream).back();
-  stream_datas_map_[stream].clear();
+  auto &&ring = stream_datas_map_[stream];
+  stream_data_t data{};
+  bool popped = false;
+  while (ring->TryPop(&data)) {
+    popped = true;
+  }
+  // another consumer may pop them meanwhile
+  if (!popped)
+    return {};
   return data;
 }
 
-const Streams::stream_datas_t &Streams::stream_datas(const Stream &stream) {
-  std::unique_lock<std::mutex> lock(mtx_);
-  try {
-    return stream_datas_map_.at(stream);
-  } catch (const std::out_of_range &e) {
-    // Add empty vector of this stream key
-    stream_datas_map_[stream] = {};
-    return stream_datas_map_.at(stream);
-  }
+const Streams::stream_data_t &Streams::pushed_stream_data(
+    const Stream &stream) {
+  return pushed_datas_map_[stream];
+}
+
+const ImgData &Streams::pushed_img_data() const {
+  return pushed_img_;
 }
 
 bool Streams::IsStreamCapability(const Capabilities &capability) const {
@@ -152,81 +293,210 @@ bool Streams::IsStreamCapability(const Capabilities &capability) const {
 }
 
 bool Streams::HasStreamConfigRequest(const Capabilities &capability) const {
-  return stream_config_requests_.find(capability) !=
-         stream_config_requests_.end();
+  return stream_config_requests_.count(capability) > 0;
 }
 
 const StreamRequest &Streams::GetStreamConfigRequest(
     const Capabilities &capability) const {
-  return stream_config_requests_.at(capability);
+  return *stream_config_requests_.find(capability);
 }
 
 bool Streams::HasStreamDatas(const Stream &stream) const {
-  return stream_datas_map_.find(stream) != stream_datas_map_.end() &&
-         !stream_datas_map_.at(stream).empty();
+  auto &&ring = stream_datas_map_.find(stream);
+  return ring && !(*ring)->empty();
 }
 
-void Streams::AllocStreamData(const Capabilities &capability,
-    const Stream &stream, const StreamRequest &request) {
-  auto format = request.format;
+Format Streams::GetFrameFormat(
+    const Capabilities &capability, const StreamRequest &request) const {
   if (capability == Capabilities::STEREO) {
-    format = Format::GREY;
+    return Format::GREY;
+  }
+  if (capability == Capabilities::STEREO_COLOR && luma_only_ &&
+      request.format == Format::YUYV) {
+    return Format::GREY;
+  }
+  return request.format;
+}
+
+void Streams::ResetFramePools() {
+  frame_pools_map_.clear();
+  img_pools_map_.clear();
+  img_stats_pools_map_.clear();
+  for (auto &&config : stream_config_requests_) {
+    auto &&capability = config.first;
+    auto &&request = config.second;
+    auto &&format = GetFrameFormat(capability, request);
+    auto width = request.width;
+    if (capability == Capabilities::STEREO_COLOR) {
+      width /= 2;  // split to half
+    }
+    for (auto &&it : stream_datas_map_) {
+      auto &&size = GetFramePoolSize(it.first);
+      frame_pools_map_[it.first] = std::make_shared<FramePool>(
+          width, request.height, format, size);
+      img_pools_map_[it.first] = std::make_shared<img_pool_t>(
+          size, [](std::size_t) { return std::make_shared<ImgData>(); });
+      if (img_stats_enabled_) {
+        img_stats_pools_map_[it.first] = std::make_shared<img_stats_pool_t>(
+            size, [](std::size_t) { return std::make_shared<ImgStats>(); });
+      }
+    }
   }
-  AllocStreamData(capability, stream, request, format);
 }
 
-void Streams::AllocStreamData(const Capabilities &capability,
-    const Stream &stream, const StreamRequest &request, const Format &format) {
+Streams::stream_data_t Streams::AllocStreamData(
+    const Capabilities &capability, const Stream &stream,
+    const StreamRequest &request, bool alloc_frame) {
+  return AllocStreamData(capability, stream, request,
+      GetFrameFormat(capability, request), alloc_frame);
+}
+
+Streams::stream_data_t Streams::AllocStreamData(
+    const Capabilities &capability, const Stream &stream,
+    const StreamRequest &request, const Format &format, bool alloc_frame) {
   stream_data_t data;
 
-  if (HasStreamDatas(stream)) {
-    // If cached equal to limits_max, drop the oldest one.
-    if (stream_datas_map_.at(stream).size() == GetStreamDataMaxSize(stream)) {
-      auto &&datas = stream_datas_map_[stream];
-      // reuse the dropped data
-      data.img = datas.front().img;
-      data.frame = datas.front().frame;
-      data.frame_id = 0;
-      datas.erase(datas.begin());
-      VLOG(2) << "Stream data of " << stream << " is dropped as out of limits";
-    }
+  auto &&ring = stream_datas_map_[stream];
+  // If cached equal to limits_max, drop the oldest one, which returns to
+  // pools if not shared
+  if (ring->size() >= ring->capacity() && ring->TryPop(nullptr)) {
+    VLOG(2) << "Stream data of " << stream << " is dropped as out of limits";
   }
 
   if (stream == Stream::LEFT || stream == Stream::RIGHT) {
-    if (!data.img) {
+    auto &&img_pool = img_pools_map_.find(stream);
+    if (img_pool) {
+      data.img = (*img_pool)->Acquire();
+    } else {
       data.img = std::make_shared<ImgData>();
     }
   } else {
     data.img = nullptr;
   }
-  if (!data.frame) {
+  if (img_stats_enabled_) {
+    auto &&img_stats_pool = img_stats_pools_map_.find(stream);
+    if (img_stats_pool) {
+      data.stats = (*img_stats_pool)->Acquire();
+    } else {
+      data.stats = std::make_shared<ImgStats>();
+    }
+  }
+  if (alloc_frame) {
     auto width = request.width;
     if (capability == Capabilities::STEREO_COLOR) {
       width /= 2;  // split to half
     }
-    data.frame =
-      std::make_shared<frame_t>(width, request.height, format, nullptr);
+    auto &&frame_pool = frame_pools_map_.find(stream);
+    if (frame_pool && (*frame_pool)->Matches(width, request.height, format)) {
+      data.frame = (*frame_pool)->Acquire();
+    } else {
+      data.frame =
+          std::make_shared<frame_t>(width, request.height, format, nullptr);
+    }
   }
   data.frame_id = 0;
-  stream_datas_map_[stream].push_back(data);
+  return data;
 }
 
-void Streams::DiscardStreamData(const Stream &stream) {
-  // Must discard after alloc, otherwise at will out of range when no this key.
-  if (stream_datas_map_.at(stream).size() > 0) {
-    auto &&datas = stream_datas_map_[stream];
-    datas.pop_back();
+bool Streams::ViewStreamFrame(const Capabilities &capability,
+    const Stream &stream, const StreamRequest &request, const void *data,
+    std::shared_ptr<void> holder, std::shared_ptr<frame_t> *frame) {
+  auto &&format = GetFrameFormat(capability, request);
+  auto width = request.width;
+  if (capability == Capabilities::STEREO_COLOR) {
+    width /= 2;  // split to half
+  }
+  std::uint8_t *pixels = nullptr;
+  std::size_t step = 0;
+  if (!view_img_pixels_map_[stream](data, request, &pixels, &step)) {
+    // alloc the frame to unpack instead
+    *frame = std::make_shared<frame_t>(width, request.height, format, nullptr);
+    return false;
+  }
+  *frame = std::make_shared<frame_t>(
+      width, request.height, format, pixels, step, holder);
+  return true;
+}
+
+void Streams::UnpackStereoFrames(const void *data,
+    const StreamRequest &request, frame_t *left, frame_t *right,
+    ImgStats *left_stats, ImgStats *right_stats) {
+  std::size_t rows = left->height();
+  bool stats = left_stats && right_stats;
+  unpack::LumaStats left_top, right_top, left_bottom, right_bottom;
+  if (unpack_worker_) {
+    // the top half on the worker, the bottom half on this thread
+    std::size_t mid = rows / 2;
+    unpack_worker_->Run(
+        [&]() {
+          UnpackStereoRows(data, request, 0, mid, left, right,
+              stats ? &left_top : nullptr, stats ? &right_top : nullptr);
+        },
+        [&]() {
+          UnpackStereoRows(data, request, mid, rows, left, right,
+              stats ? &left_bottom : nullptr, stats ? &right_bottom : nullptr);
+        });
   } else {
-    VLOG(2) << "Stream data of " << stream << " is empty, could not discard";
+    UnpackStereoRows(data, request, 0, rows, left, right,
+        stats ? &left_top : nullptr, stats ? &right_top : nullptr);
+  }
+  if (stats) {
+    left_top.Merge(left_bottom);
+    right_top.Merge(right_bottom);
+    left_top.To(left_stats);
+    right_top.To(right_stats);
   }
 }
 
+void Streams::UnpackStereoRows(const void *data,
+    const StreamRequest &request, std::size_t row_beg, std::size_t row_end,
+    frame_t *left, frame_t *right, unpack::LumaStats *left_stats,
+    unpack::LumaStats *right_stats) {
+  if (!left_stats || !right_stats) {
+    unpack_stereo_img_pixels_(data, request, row_beg, row_end, left, right);
+    return;
+  }
+  // unpack by bands, and accumulate the stats of each band still in cache
+  const std::size_t band_rows = 16;
+  for (std::size_t beg = row_beg; beg < row_end; beg += band_rows) {
+    std::size_t end = std::min(beg + band_rows, row_end);
+    unpack_stereo_img_pixels_(data, request, beg, end, left, right);
+    for (std::size_t i = beg; i < end; i++) {
+      unpack::luma_stats(left->data() + i * left->step(), left->width(),
+          left->format(), left_stats);
+      unpack::luma_stats(right->data() + i * right->step(), right->width(),
+          right->format(), right_stats);
+    }
+  }
+}
+
+void Streams::ComputeImgStats(const frame_t &frame, ImgStats *stats) {
+  unpack::LumaStats luma_stats;
+  for (std::size_t i = 0; i < frame.height(); i++) {
+    unpack::luma_stats(frame.data() + i * frame.step(), frame.width(),
+        frame.format(), &luma_stats);
+  }
+  luma_stats.To(stats);
+}
+
+void Streams::PushStreamData(const Stream &stream, const stream_data_t &data) {
+  if (stream_datas_map_[stream]->PushOverwrite(data) > 0) {
+    VLOG(2) << "Stream data of " << stream << " is dropped as out of limits";
+  }
+  pushed_datas_map_[stream] = data;
+}
+
 bool Streams::HasKeyStreamDatas() const {
+  bool demanded = false;
   for (auto &&s : key_streams_) {
+    // not demanded ones are never pushed
+    if (!IsStreamDemanded(s))
+      continue;
     if (!HasStreamDatas(s))
       return false;
+    demanded = true;
   }
-  return true;
+  return demanded;
 }
 
 MYNTEYE_END_NAMESPACE
@@ -15,6 +15,7 @@
 #define MYNTEYE_DEVICE_STREAMS_H_
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <map>
@@ -25,6 +26,12 @@
 #include "mynteye/mynteye.h"
 #include "mynteye/types.h"
 #include "mynteye/device/callbacks.h"
+#include "mynteye/device/frame_pool.h"
+#include "mynteye/device/unpack.h"
+#include "mynteye/util/enum_map.h"
+#include "mynteye/util/object_pool.h"
+#include "mynteye/util/ring_buffer.h"
+#include "mynteye/uvc/uvc.h"
 
 MYNTEYE_BEGIN_NAMESPACE
 
@@ -36,10 +43,19 @@ class Streams {
   using stream_data_t = device::StreamData;
   using stream_datas_t = std::vector<stream_data_t>;
 
-  using unpack_img_data_t = std::function<bool(
-      const void *data, const StreamRequest &request, ImgData *img)>;
-  using unpack_img_pixels_t = std::function<bool(
-      const void *data, const StreamRequest &request, frame_t *frame)>;
+  // Functions of adapters are bound statically, called directly per frame
+  using unpack_img_data_t = bool (*)(
+      const void *data, const StreamRequest &request, ImgData *img);
+  using unpack_img_pixels_t = bool (*)(
+      const void *data, const StreamRequest &request, frame_t *frame);
+  // Get the pixels and row step of the stream inside data, without copy
+  using view_img_pixels_t = bool (*)(
+      const void *data, const StreamRequest &request,
+      std::uint8_t **pixels, std::size_t *step);
+  // Unpack the rows [row_beg, row_end) of left and right in one pass
+  using unpack_stereo_img_pixels_t = bool (*)(
+      const void *data, const StreamRequest &request, std::size_t row_beg,
+      std::size_t row_end, frame_t *left, frame_t *right);
 
   explicit Streams(const std::shared_ptr<StreamsAdapter> &adapter);
   ~Streams();
@@ -48,16 +64,52 @@ class Streams {
       const Capabilities &capability, const StreamRequest &request);
 
   bool PushStream(const Capabilities &capability, const void *data);
+  // info: capture info of data, fill into img data
+  // holder: keeps data alive, frames will view the data instead of unpacking
+  //   if supported by the stream
+  bool PushStream(const Capabilities &capability, const void *data,
+      const uvc::frame_info &info, std::shared_ptr<void> holder);
 
   void WaitForStreams();
 
+  // Unpack left and right in two threads, the other is a capture thread.
+  // Must be called before pushing streams.
+  void EnableParallelUnpack(bool enabled);
+
+  // Unpack only the luma of STEREO_COLOR in YUYV, to frames in GREY. Must be
+  // called before pushing streams
+  void EnableLumaOnly(bool enabled);
+
+  // Compute the img stats of frames while unpacking. Must be called before
+  // pushing streams
+  void EnableImgStats(bool enabled);
+
+  // Whether the stream is demanded by a callback. The stream is also demanded
+  // once its datas are got. Only demanded streams are unpacked, or all if
+  // none is demanded.
+  void SetStreamDemanded(const Stream &stream, bool demanded);
+  bool IsStreamDemanded(const Stream &stream) const;
+
+  // Must be called before pushing streams, as it replaces the ring
   void ConfigStreamLimits(const Stream &stream, std::size_t max_data_size);
   std::size_t GetStreamDataMaxSize(const Stream &stream) const;
 
+  // Frames of each stream, 0 for the default size that is the max data size
+  // plus 4. Must be called before pushing streams
+  void ConfigFramePool(std::size_t size);
+  std::size_t GetFramePoolSize(const Stream &stream) const;
+  // Acquires of frames from pools, and the misses out of pools
+  void GetFramePoolStats(std::uint64_t *hits, std::uint64_t *misses) const;
+  void ResetFramePoolStats();
+
   stream_datas_t GetStreamDatas(const Stream &stream);
   stream_data_t GetLatestStreamData(const Stream &stream);
 
-  const stream_datas_t &stream_datas(const Stream &stream);
+  // The last pushed data of the stream, only for the pushing thread
+  const stream_data_t &pushed_stream_data(const Stream &stream);
+  // The last accepted img data, even if no stream demanded, only for the
+  // pushing thread
+  const ImgData &pushed_img_data() const;
 
  private:
   bool IsStreamCapability(const Capabilities &capability) const;
@@ -68,25 +120,73 @@ class Streams {
 
   bool HasStreamDatas(const Stream &stream) const;
 
-  void AllocStreamData(const Capabilities &capability,
-      const Stream &stream, const StreamRequest &request);
-  void AllocStreamData(const Capabilities &capability,
-      const Stream &stream, const StreamRequest &request, const Format &format);
+  // Format of frames unpacked from the request
+  Format GetFrameFormat(
+      const Capabilities &capability, const StreamRequest &request) const;
+
+  void ResetFramePools();
 
-  void DiscardStreamData(const Stream &stream);
+  stream_data_t AllocStreamData(const Capabilities &capability,
+      const Stream &stream, const StreamRequest &request,
+      bool alloc_frame = true);
+  stream_data_t AllocStreamData(const Capabilities &capability,
+      const Stream &stream, const StreamRequest &request, const Format &format,
+      bool alloc_frame);
+
+  bool ViewStreamFrame(const Capabilities &capability, const Stream &stream,
+      const StreamRequest &request, const void *data,
+      std::shared_ptr<void> holder, std::shared_ptr<frame_t> *frame);
+
+  // left_stats, right_stats: computed by bands of rows just unpacked if not
+  //   null
+  void UnpackStereoFrames(const void *data, const StreamRequest &request,
+      frame_t *left, frame_t *right, ImgStats *left_stats = nullptr,
+      ImgStats *right_stats = nullptr);
+  void UnpackStereoRows(const void *data, const StreamRequest &request,
+      std::size_t row_beg, std::size_t row_end, frame_t *left, frame_t *right,
+      unpack::LumaStats *left_stats, unpack::LumaStats *right_stats);
+
+  void ComputeImgStats(const frame_t &frame, ImgStats *stats);
+
+  void PushStreamData(const Stream &stream, const stream_data_t &data);
 
   bool HasKeyStreamDatas() const;
 
   std::vector<Stream> key_streams_;
 
   std::vector<Capabilities> stream_capabilities_;
-  std::map<Capabilities, StreamRequest> stream_config_requests_;
-
-  std::map<Stream, unpack_img_data_t> unpack_img_data_map_;
-  std::map<Stream, unpack_img_pixels_t> unpack_img_pixels_map_;
-
-  std::map<Stream, std::size_t> stream_limits_map_;
-  std::map<Stream, stream_datas_t> stream_datas_map_;
+  EnumMap<Capabilities, StreamRequest> stream_config_requests_;
+
+  EnumMap<Stream, unpack_img_data_t> unpack_img_data_map_;
+  EnumMap<Stream, unpack_img_pixels_t> unpack_img_pixels_map_;
+  EnumMap<Stream, view_img_pixels_t> view_img_pixels_map_;
+  unpack_stereo_img_pixels_t unpack_stereo_img_pixels_;
+  std::shared_ptr<unpack::Worker> unpack_worker_;
+  bool luma_only_;
+  bool img_stats_enabled_;
+
+  // Stream datas are pushed by the capture thread and popped by the others,
+  // the mutex is only for waiting key streams
+  using stream_datas_ring_t = RingBuffer<stream_data_t>;
+
+  EnumMap<Stream, std::size_t> stream_limits_map_;
+  EnumMap<Stream, std::shared_ptr<stream_datas_ring_t>> stream_datas_map_;
+  EnumMap<Stream, stream_data_t> pushed_datas_map_;
+  ImgData pushed_img_;
+
+  // Frames and img datas are acquired from pools, and return once released
+  using img_pool_t = ObjectPool<ImgData>;
+  using img_stats_pool_t = ObjectPool<ImgStats>;
+
+  std::size_t frame_pool_size_;
+  EnumMap<Stream, std::shared_ptr<FramePool>> frame_pools_map_;
+  EnumMap<Stream, std::shared_ptr<img_pool_t>> img_pools_map_;
+  EnumMap<Stream, std::shared_ptr<img_stats_pool_t>>
+      img_stats_pools_map_;
+
+  // Demands of streams, set by other threads while pushing
+  EnumMap<Stream, std::atomic<bool>> callback_demands_map_;
+  EnumMap<Stream, std::atomic<bool>> consumer_demands_map_;
 
   std::mutex mtx_;
   std::condition_variable cv_;
@@ -103,6 +203,15 @@ class StreamsAdapter {
   GetUnpackImgDataMap() = 0;
   virtual std::map<Stream, Streams::unpack_img_pixels_t>
   GetUnpackImgPixelsMap() = 0;
+  // Streams could be viewed without copy, none by default
+  virtual std::map<Stream, Streams::view_img_pixels_t>
+  GetViewImgPixelsMap() {
+    return {};
+  }
+  // Left and right could be unpacked in one pass, none by default
+  virtual Streams::unpack_stereo_img_pixels_t GetUnpackStereoImgPixels() {
+    return nullptr;
+  }
 };
 
 MYNTEYE_END_NAMESPACE
@@ -0,0 +1,629 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "mynteye/device/unpack.h"
+
+#include <algorithm>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+#define MYNTEYE_UNPACK_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__aarch64__)
+#define MYNTEYE_UNPACK_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(MYNTEYE_UNPACK_X86) && (defined(__GNUC__) || defined(__clang__))
+#define MYNTEYE_UNPACK_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MYNTEYE_UNPACK_TARGET(isa)
+#endif
+
+#include "mynteye/logger.h"
+#include "mynteye/util/threads.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+namespace unpack {
+
+namespace {
+
+using deinterleave_t = void (*)(
+    const std::uint8_t *, std::uint8_t *, std::uint8_t *, std::size_t);
+using pick_t =
+    void (*)(const std::uint8_t *, std::uint8_t *, std::size_t, int);
+using swap_rb_t = void (*)(const std::uint8_t *, std::uint8_t *, std::size_t);
+using yuyv_to_bgr_t =
+    void (*)(const std::uint8_t *, std::uint8_t *, std::size_t);
+
+struct kernels {
+  const char *isa;
+  deinterleave_t deinterleave;
+  pick_t pick;
+  swap_rb_t swap_rb;
+  yuyv_to_bgr_t yuyv_to_bgr;
+};
+
+// Coefficients of BT.601 limited range, scaled by 64:
+//   B = 1.164 (Y - 16) + 2.018 (U - 128)
+//   G = 1.164 (Y - 16) - 0.813 (V - 128) - 0.391 (U - 128)
+//   R = 1.164 (Y - 16) + 1.596 (V - 128)
+// All terms fit in int16, only the sums of B and R may saturate, which are
+// out of 255 then.
+enum : std::int16_t {
+  YUV_Y = 74,
+  YUV_UB = 129,
+  YUV_VG = 52,
+  YUV_UG = 25,
+  YUV_VR = 102,
+};
+
+// scalar
+
+void deinterleave_scalar(
+    const std::uint8_t *src, std::uint8_t *even, std::uint8_t *odd,
+    std::size_t n) {
+  for (std::size_t i = 0; i < n; i++) {
+    even[i] = src[2 * i];
+    odd[i] = src[2 * i + 1];
+  }
+}
+
+void pick_scalar(
+    const std::uint8_t *src, std::uint8_t *dst, std::size_t n, int offset) {
+  for (std::size_t i = 0; i < n; i++) {
+    dst[i] = src[2 * i + offset];
+  }
+}
+
+void swap_rb_scalar(const std::uint8_t *src, std::uint8_t *dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; i++) {
+    dst[3 * i] = src[3 * i + 2];
+    dst[3 * i + 1] = src[3 * i + 1];
+    dst[3 * i + 2] = src[3 * i];
+  }
+}
+
+// 0.114 B + 0.587 G + 0.299 R, scaled by 256
+inline std::uint8_t bgr_luma(const std::uint8_t *bgr) {
+  return static_cast<std::uint8_t>(
+      (29 * bgr[0] + 150 * bgr[1] + 77 * bgr[2] + 128) >> 8);
+}
+
+inline std::uint8_t yuv_clamp(int x) {
+  x = (x + 32) >> 6;
+  return static_cast<std::uint8_t>(x < 0 ? 0 : (x > 255 ? 255 : x));
+}
+
+void yuyv_to_bgr_scalar(
+    const std::uint8_t *src, std::uint8_t *dst, std::size_t n) {
+  for (std::size_t i = 0; i + 2 <= n; i += 2) {
+    const std::uint8_t *yuyv = src + 2 * i;
+    int u = yuyv[1] - 128;
+    int v = yuyv[3] - 128;
+    int ub = YUV_UB * u;
+    int uvg = -YUV_VG * v - YUV_UG * u;
+    int vr = YUV_VR * v;
+    for (int k = 0; k < 2; k++) {
+      int y = YUV_Y * (yuyv[2 * k] - 16);
+      std::uint8_t *bgr = dst + 3 * (i + k);
+      bgr[0] = yuv_clamp(y + ub);
+      bgr[1] = yuv_clamp(y + uvg);
+      bgr[2] = yuv_clamp(y + vr);
+    }
+  }
+}
+
+#if defined(MYNTEYE_UNPACK_X86)
+
+// sse2, ssse3
+
+MYNTEYE_UNPACK_TARGET("sse2")
+void deinterleave_sse2(
+    const std::uint8_t *src, std::uint8_t *even, std::uint8_t *odd,
+    std::size_t n) {
+  const __m128i mask = _mm_set1_epi16(0x00FF);
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    auto &&p = reinterpret_cast<const __m128i *>(src + 2 * i);
+    __m128i a = _mm_loadu_si128(p);
+    __m128i b = _mm_loadu_si128(p + 1);
+    __m128i e =
+        _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask));
+    __m128i o = _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(even + i), e);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(odd + i), o);
+  }
+  deinterleave_scalar(src + 2 * i, even + i, odd + i, n - i);
+}
+
+MYNTEYE_UNPACK_TARGET("sse2")
+void pick_sse2(
+    const std::uint8_t *src, std::uint8_t *dst, std::size_t n, int offset) {
+  const __m128i mask = _mm_set1_epi16(0x00FF);
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    auto &&p = reinterpret_cast<const __m128i *>(src + 2 * i);
+    __m128i a = _mm_loadu_si128(p);
+    __m128i b = _mm_loadu_si128(p + 1);
+    if (offset == 0) {
+      a = _mm_and_si128(a, mask);
+      b = _mm_and_si128(b, mask);
+    } else {
+      a = _mm_srli_epi16(a, 8);
+      b = _mm_srli_epi16(b, 8);
+    }
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(a, b));
+  }
+  pick_scalar(src + 2 * i, dst + i, n - i, offset);
+}
+
+MYNTEYE_UNPACK_TARGET("ssse3")
+void swap_rb_ssse3(const std::uint8_t *src, std::uint8_t *dst, std::size_t n) {
+  // 5 pixels in 16 bytes a time, the last byte is rewritten by the next
+  const __m128i shuffle = _mm_setr_epi8(
+      2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+  std::size_t i = 0;
+  for (; i + 6 <= n; i += 5) {
+    __m128i a =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 3 * i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 3 * i),
+        _mm_shuffle_epi8(a, shuffle));
+  }
+  swap_rb_scalar(src + 3 * i, dst + 3 * i, n - i);
+}
+
+// Convert 8 YUYV pixels to BGR in int16
+MYNTEYE_UNPACK_TARGET("ssse3")
+inline void yuyv_to_bgr_epi16(
+    __m128i a, __m128i *b, __m128i *g, __m128i *r) {
+  const __m128i lo = _mm_set1_epi32(0x0000FFFF);
+  __m128i y = _mm_and_si128(a, _mm_set1_epi16(0x00FF));
+  __m128i uv = _mm_srli_epi16(a, 8);
+  // duplicate u, v to both pixels of a pair
+  __m128i u = _mm_and_si128(uv, lo);
+  u = _mm_or_si128(u, _mm_slli_epi32(u, 16));
+  __m128i v = _mm_srli_epi32(uv, 16);
+  v = _mm_or_si128(v, _mm_slli_epi32(v, 16));
+  y = _mm_mullo_epi16(
+      _mm_sub_epi16(y, _mm_set1_epi16(16)), _mm_set1_epi16(YUV_Y));
+  u = _mm_sub_epi16(u, _mm_set1_epi16(128));
+  v = _mm_sub_epi16(v, _mm_set1_epi16(128));
+  *b = _mm_adds_epi16(y, _mm_mullo_epi16(u, _mm_set1_epi16(YUV_UB)));
+  *g = _mm_sub_epi16(
+      _mm_sub_epi16(y, _mm_mullo_epi16(v, _mm_set1_epi16(YUV_VG))),
+      _mm_mullo_epi16(u, _mm_set1_epi16(YUV_UG)));
+  *r = _mm_adds_epi16(y, _mm_mullo_epi16(v, _mm_set1_epi16(YUV_VR)));
+  const __m128i half = _mm_set1_epi16(32);
+  *b = _mm_srai_epi16(_mm_adds_epi16(*b, half), 6);
+  *g = _mm_srai_epi16(_mm_adds_epi16(*g, half), 6);
+  *r = _mm_srai_epi16(_mm_adds_epi16(*r, half), 6);
+}
+
+MYNTEYE_UNPACK_TARGET("ssse3")
+void yuyv_to_bgr_ssse3(
+    const std::uint8_t *src, std::uint8_t *dst, std::size_t n) {
+  // interleave 16 bytes of b, g, r to 48 bytes, each output takes bytes of
+  // the three by shuffles
+  const __m128i b0 = _mm_setr_epi8(
+      0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5);
+  const __m128i g0 = _mm_setr_epi8(
+      -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1);
+  const __m128i r0 = _mm_setr_epi8(
+      -1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+  const __m128i b1 = _mm_setr_epi8(
+      -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1);
+  const __m128i g1 = _mm_setr_epi8(
+      5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10);
+  const __m128i r1 = _mm_setr_epi8(
+      -1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1);
+  const __m128i b2 = _mm_setr_epi8(
+      -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+  const __m128i g2 = _mm_setr_epi8(
+      -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+  const __m128i r2 = _mm_setr_epi8(
+      10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    auto &&p = reinterpret_cast<const __m128i *>(src + 2 * i);
+    __m128i b_lo, g_lo, r_lo, b_hi, g_hi, r_hi;
+    yuyv_to_bgr_epi16(_mm_loadu_si128(p), &b_lo, &g_lo, &r_lo);
+    yuyv_to_bgr_epi16(_mm_loadu_si128(p + 1), &b_hi, &g_hi, &r_hi);
+    __m128i b = _mm_packus_epi16(b_lo, b_hi);
+    __m128i g = _mm_packus_epi16(g_lo, g_hi);
+    __m128i r = _mm_packus_epi16(r_lo, r_hi);
+    auto &&q = reinterpret_cast<__m128i *>(dst + 3 * i);
+    _mm_storeu_si128(q, _mm_or_si128(_mm_or_si128(
+        _mm_shuffle_epi8(b, b0), _mm_shuffle_epi8(g, g0)),
+        _mm_shuffle_epi8(r, r0)));
+    _mm_storeu_si128(q + 1, _mm_or_si128(_mm_or_si128(
+        _mm_shuffle_epi8(b, b1), _mm_shuffle_epi8(g, g1)),
+        _mm_shuffle_epi8(r, r1)));
+    _mm_storeu_si128(q + 2, _mm_or_si128(_mm_or_si128(
+        _mm_shuffle_epi8(b, b2), _mm_shuffle_epi8(g, g2)),
+        _mm_shuffle_epi8(r, r2)));
+  }
+  yuyv_to_bgr_scalar(src + 2 * i, dst + 3 * i, n - i);
+}
+
+// avx2
+
+MYNTEYE_UNPACK_TARGET("avx2")
+void deinterleave_avx2(
+    const std::uint8_t *src, std::uint8_t *even, std::uint8_t *odd,
+    std::size_t n) {
+  const __m256i mask = _mm256_set1_epi16(0x00FF);
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    auto &&p = reinterpret_cast<const __m256i *>(src + 2 * i);
+    __m256i a = _mm256_loadu_si256(p);
+    __m256i b = _mm256_loadu_si256(p + 1);
+    // packs within 128-bit lanes, then reorders the 64-bit quarters
+    __m256i e = _mm256_packus_epi16(
+        _mm256_and_si256(a, mask), _mm256_and_si256(b, mask));
+    __m256i o =
+        _mm256_packus_epi16(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8));
+    e = _mm256_permute4x64_epi64(e, 0xD8);
+    o = _mm256_permute4x64_epi64(o, 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(even + i), e);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(odd + i), o);
+  }
+  deinterleave_sse2(src + 2 * i, even + i, odd + i, n - i);
+}
+
+MYNTEYE_UNPACK_TARGET("avx2")
+void pick_avx2(
+    const std::uint8_t *src, std::uint8_t *dst, std::size_t n, int offset) {
+  const __m256i mask = _mm256_set1_epi16(0x00FF);
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    auto &&p = reinterpret_cast<const __m256i *>(src + 2 * i);
+    __m256i a = _mm256_loadu_si256(p);
+    __m256i b = _mm256_loadu_si256(p + 1);
+    if (offset == 0) {
+      a = _mm256_and_si256(a, mask);
+      b = _mm256_and_si256(b, mask);
+    } else {
+      a = _mm256_srli_epi16(a, 8);
+      b = _mm256_srli_epi16(b, 8);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+        _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+  }
+  pick_sse2(src + 2 * i, dst + i, n - i, offset);
+}
+
+MYNTEYE_UNPACK_TARGET("avx2")
+void swap_rb_avx2(const std::uint8_t *src, std::uint8_t *dst, std::size_t n) {
+  // 10 pixels a time, 5 pixels in each 128-bit lane
+  const __m256i shuffle = _mm256_setr_epi8(
+      2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15,
+      2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+  std::size_t i = 0;
+  for (; i + 11 <= n; i += 10) {
+    __m256i a = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 3 * i))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 3 * i + 15)),
+        1);
+    a = _mm256_shuffle_epi8(a, shuffle);
+    // the low lane first, so that the high one rewrites the overlapped byte
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 3 * i),
+        _mm256_castsi256_si128(a));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 3 * i + 15),
+        _mm256_extracti128_si256(a, 1));
+  }
+  swap_rb_ssse3(src + 3 * i, dst + 3 * i, n - i);
+}
+
+bool cpu_supports_ssse3() {
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  return (info[2] & (1 << 9)) != 0;
+#else
+  return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+bool cpu_supports_avx2() {
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return false;
+  __cpuid(info, 1);
+  // the os saves the ymm registers
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  if (!osxsave || (_xgetbv(0) & 0x6) != 0x6)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#elif defined(MYNTEYE_UNPACK_NEON)
+
+// neon
+
+void deinterleave_neon(
+    const std::uint8_t *src, std::uint8_t *even, std::uint8_t *odd,
+    std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    uint8x16x2_t v = vld2q_u8(src + 2 * i);
+    vst1q_u8(even + i, v.val[0]);
+    vst1q_u8(odd + i, v.val[1]);
+  }
+  deinterleave_scalar(src + 2 * i, even + i, odd + i, n - i);
+}
+
+void pick_neon(
+    const std::uint8_t *src, std::uint8_t *dst, std::size_t n, int offset) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    uint8x16x2_t v = vld2q_u8(src + 2 * i);
+    vst1q_u8(dst + i, offset == 0 ? v.val[0] : v.val[1]);
+  }
+  pick_scalar(src + 2 * i, dst + i, n - i, offset);
+}
+
+void swap_rb_neon(const std::uint8_t *src, std::uint8_t *dst, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    uint8x16x3_t v = vld3q_u8(src + 3 * i);
+    uint8x16_t r = v.val[0];
+    v.val[0] = v.val[2];
+    v.val[2] = r;
+    vst3q_u8(dst + 3 * i, v);
+  }
+  swap_rb_scalar(src + 3 * i, dst + 3 * i, n - i);
+}
+
+// Convert 8 pixels, y of the even or odd ones and u, v of both in int16
+inline uint8x8_t yuv_to_u8(int16x8_t y, int16x8_t uv) {
+  return vqrshrun_n_s16(vqaddq_s16(y, uv), 6);
+}
+
+void yuyv_to_bgr_neon(
+    const std::uint8_t *src, std::uint8_t *dst, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    // y of even pixels, u, y of odd pixels, v
+    uint8x8x4_t v = vld4_u8(src + 2 * i);
+    int16x8_t y0 = vmulq_n_s16(vsubq_s16(vreinterpretq_s16_u16(
+        vmovl_u8(v.val[0])), vdupq_n_s16(16)), YUV_Y);
+    int16x8_t y1 = vmulq_n_s16(vsubq_s16(vreinterpretq_s16_u16(
+        vmovl_u8(v.val[2])), vdupq_n_s16(16)), YUV_Y);
+    int16x8_t u = vsubq_s16(
+        vreinterpretq_s16_u16(vmovl_u8(v.val[1])), vdupq_n_s16(128));
+    int16x8_t w = vsubq_s16(
+        vreinterpretq_s16_u16(vmovl_u8(v.val[3])), vdupq_n_s16(128));
+    int16x8_t ub = vmulq_n_s16(u, YUV_UB);
+    int16x8_t uvg = vsubq_s16(
+        vnegq_s16(vmulq_n_s16(w, YUV_VG)), vmulq_n_s16(u, YUV_UG));
+    int16x8_t vr = vmulq_n_s16(w, YUV_VR);
+    uint8x8x2_t b = vzip_u8(yuv_to_u8(y0, ub), yuv_to_u8(y1, ub));
+    uint8x8x2_t g = vzip_u8(yuv_to_u8(y0, uvg), yuv_to_u8(y1, uvg));
+    uint8x8x2_t r = vzip_u8(yuv_to_u8(y0, vr), yuv_to_u8(y1, vr));
+    uint8x16x3_t bgr;
+    bgr.val[0] = vcombine_u8(b.val[0], b.val[1]);
+    bgr.val[1] = vcombine_u8(g.val[0], g.val[1]);
+    bgr.val[2] = vcombine_u8(r.val[0], r.val[1]);
+    vst3q_u8(dst + 3 * i, bgr);
+  }
+  yuyv_to_bgr_scalar(src + 2 * i, dst + 3 * i, n - i);
+}
+
+#endif
+
+kernels select_kernels() {
+#if defined(MYNTEYE_UNPACK_X86)
+  if (cpu_supports_avx2())
+    return {"avx2", deinterleave_avx2, pick_avx2, swap_rb_avx2,
+        yuyv_to_bgr_ssse3};
+  if (cpu_supports_ssse3())
+    return {"ssse3", deinterleave_sse2, pick_sse2, swap_rb_ssse3,
+        yuyv_to_bgr_ssse3};
+  return {"sse2", deinterleave_sse2, pick_sse2, swap_rb_scalar,
+      yuyv_to_bgr_scalar};
+#elif defined(MYNTEYE_UNPACK_NEON)
+  return {"neon", deinterleave_neon, pick_neon, swap_rb_neon,
+      yuyv_to_bgr_neon};
+#else
+  return {"scalar", deinterleave_scalar, pick_scalar, swap_rb_scalar,
+      yuyv_to_bgr_scalar};
+#endif
+}
+
+const kernels &get_kernels() {
+  static const kernels k = []() -> kernels {
+    auto &&k = select_kernels();
+    VLOG(2) << "Unpack with " << k.isa;
+    return k;
+  }();
+  return k;
+}
+
+}  // namespace
+
+const char *isa() {
+  return get_kernels().isa;
+}
+
+void deinterleave(
+    const std::uint8_t *src, std::uint8_t *even, std::uint8_t *odd,
+    std::size_t n) {
+  get_kernels().deinterleave(src, even, odd, n);
+}
+
+void pick(
+    const std::uint8_t *src, std::uint8_t *dst, std::size_t n, int offset) {
+  get_kernels().pick(src, dst, n, offset);
+}
+
+void swap_rb(const std::uint8_t *src, std::uint8_t *dst, std::size_t n) {
+  get_kernels().swap_rb(src, dst, n);
+}
+
+void yuyv_to_bgr(const std::uint8_t *src, std::uint8_t *dst, std::size_t n) {
+  get_kernels().yuyv_to_bgr(src, dst, n);
+}
+
+void bgr_to_gray(const std::uint8_t *src, std::uint8_t *dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; i++) {
+    dst[i] = bgr_luma(src + 3 * i);
+  }
+}
+
+// LumaStats
+
+void LumaStats::Reset() {
+  std::fill(histogram, histogram + 256, 0);
+  sum = 0;
+  gradient_sum = 0;
+  gradient_count = 0;
+}
+
+void LumaStats::Merge(const LumaStats &other) {
+  for (int i = 0; i < 256; i++) {
+    histogram[i] += other.histogram[i];
+  }
+  sum += other.sum;
+  gradient_sum += other.gradient_sum;
+  gradient_count += other.gradient_count;
+}
+
+void LumaStats::To(ImgStats *stats) const {
+  std::uint64_t count = 0;
+  for (int i = 0; i < 256; i++) {
+    stats->histogram[i] = histogram[i];
+    count += histogram[i];
+  }
+  stats->mean = count > 0 ? static_cast<double>(sum) / count : 0;
+  stats->saturated_ratio =
+      count > 0 ? static_cast<double>(histogram[255]) / count : 0;
+  stats->sharpness = gradient_count > 0 ?
+      static_cast<double>(gradient_sum) / gradient_count : 0;
+}
+
+namespace {
+
+template <std::size_t STRIDE>
+void luma_stats_stride(
+    const std::uint8_t *row, std::size_t n, LumaStats *stats) {
+  if (n == 0)
+    return;
+  std::uint32_t sum = 0;
+  std::uint64_t gradient_sum = 0;
+  int prev = row[0];
+  for (std::size_t i = 0; i < n; i++) {
+    int y = row[STRIDE * i];
+    ++stats->histogram[y];
+    sum += y;
+    gradient_sum += (y - prev) * (y - prev);
+    prev = y;
+  }
+  stats->sum += sum;
+  stats->gradient_sum += gradient_sum;
+  stats->gradient_count += n - 1;
+}
+
+}  // namespace
+
+void luma_stats(const std::uint8_t *row, std::size_t n, Format format,
+    LumaStats *stats) {
+  switch (format) {
+    case Format::GREY:
+      luma_stats_stride<1>(row, n, stats);
+      break;
+    case Format::YUYV:
+      luma_stats_stride<2>(row, n, stats);
+      break;
+    case Format::BGR888: {
+      // convert by chunks on stack, then as grey
+      std::uint8_t luma[256];
+      for (std::size_t i = 0; i < n; i += 256) {
+        std::size_t m = std::min<std::size_t>(256, n - i);
+        bgr_to_gray(row + 3 * i, luma, m);
+        luma_stats_stride<1>(luma, m, stats);
+        if (i > 0) {
+          // the gradient across chunks
+          int d = luma[0] - bgr_luma(row + 3 * (i - 1));
+          stats->gradient_sum += d * d;
+          ++stats->gradient_count;
+        }
+      }
+    } break;
+    default:
+      break;
+  }
+}
+
+// Worker
+
+Worker::Worker() : task_(nullptr), task_done_(true), running_(true) {
+  VLOG(2) << __func__;
+  thread_ = std::thread(&Worker::Loop, this);
+}
+
+Worker::~Worker() {
+  VLOG(2) << __func__;
+  {
+    std::lock_guard<std::mutex> _(mtx_);
+    running_ = false;
+  }
+  cv_.notify_all();
+  thread_.join();
+}
+
+void Worker::Run(std::function<void()> task, std::function<void()> other) {
+  {
+    std::lock_guard<std::mutex> _(mtx_);
+    task_ = std::move(task);
+    task_done_ = false;
+  }
+  cv_.notify_all();
+  other();
+  std::unique_lock<std::mutex> lock(mtx_);
+  cv_.wait(lock, [this] { return task_done_; });
+}
+
+void Worker::Loop() {
+  threads::Scope scope(threads::Role::CAPTURE, "unpack");
+  std::unique_lock<std::mutex> lock(mtx_);
+  while (true) {
+    cv_.wait(lock, [this] { return !running_ || task_; });
+    if (!running_)
+      break;
+    auto task = std::move(task_);
+    task_ = nullptr;
+    lock.unlock();
+    task();
+    lock.lock();
+    task_done_ = true;
+    cv_.notify_all();
+  }
+}
+
+}  // namespace unpack
+
+MYNTEYE_END_NAMESPACE
@@ -0,0 +1,99 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef MYNTEYE_DEVICE_UNPACK_H_
+#define MYNTEYE_DEVICE_UNPACK_H_
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "mynteye/mynteye.h"
+#include "mynteye/types.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+// Kernels to unpack stereo payloads, vectorized with the best instruction set
+// of the cpu, which is chosen at runtime.
+namespace unpack {
+
+// Name of the instruction set chosen, such as "avx2"
+const char *isa();
+
+// Deinterleave n byte pairs, the first bytes to even, the second to odd
+void deinterleave(
+    const std::uint8_t *src, std::uint8_t *even, std::uint8_t *odd,
+    std::size_t n);
+
+// Pick the byte of offset 0 or 1 in n byte pairs
+void pick(
+    const std::uint8_t *src, std::uint8_t *dst, std::size_t n, int offset);
+
+// Swap the first and third bytes of n 3-byte pixels, RGB to BGR
+void swap_rb(const std::uint8_t *src, std::uint8_t *dst, std::size_t n);
+
+// Convert n YUYV pixels to BGR, n is even. BT.601 as OpenCV, in fixed point
+void yuyv_to_bgr(const std::uint8_t *src, std::uint8_t *dst, std::size_t n);
+
+// Convert n BGR pixels to gray
+void bgr_to_gray(const std::uint8_t *src, std::uint8_t *dst, std::size_t n);
+
+// Statistics of luma accumulated by rows
+struct LumaStats {
+  std::uint32_t histogram[256];
+  std::uint64_t sum;
+  std::uint64_t gradient_sum;
+  std::uint64_t gradient_count;
+
+  LumaStats() {
+    Reset();
+  }
+
+  void Reset();
+  void Merge(const LumaStats &other);
+  void To(ImgStats *stats) const;
+};
+
+// Accumulate the luma of a row of n pixels in format GREY, YUYV or BGR888
+void luma_stats(const std::uint8_t *row, std::size_t n, Format format,
+    LumaStats *stats);
+
+// Helper thread to split an unpack into two parts
+class Worker {
+ public:
+  Worker();
+  ~Worker();
+
+  // Run task on the helper thread and other on this thread, wait both done
+  void Run(std::function<void()> task, std::function<void()> other);
+
+ private:
+  void Loop();
+
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  std::function<void()> task_;
+  bool task_done_;
+  bool running_;
+  std::thread thread_;
+};
+
+}  // namespace unpack
+
+MYNTEYE_END_NAMESPACE
+
+#endif  // MYNTEYE_DEVICE_UNPACK_H_
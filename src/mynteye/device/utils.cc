@@ -29,9 +29,9 @@ namespace device {
 std::shared_ptr<Device> select() {
   LOG(INFO) << "Detecting MYNT EYE devices";
   Context context;
-  auto &&devices = context.devices();
+  auto &&descs = context.descs();
 
-  std::size_t n = devices.size();
+  std::size_t n = descs.size();
   if (n <= 0) {
     LOG(ERROR) << "No MYNT EYE devices :(";
     return nullptr;
@@ -39,30 +39,32 @@ std::shared_ptr<Device> select() {
 
   LOG(INFO) << "MYNT EYE devices:";
   for (std::size_t i = 0; i < n; i++) {
-    auto &&device = devices[i];
-    LOG(INFO) << "  index: " << i
-              << ", name: " << device->GetInfo(Info::DEVICE_NAME)
-              << ", sn: " << device->GetInfo(Info::SERIAL_NUMBER);
+    auto &&desc = descs[i];
+    LOG(INFO) << "  index: " << i << ", name: " << desc.name
+              << ", serial: " << desc.serial << ", bus: " << desc.bus_path;
   }
 
-  std::shared_ptr<Device> device = nullptr;
+  std::size_t index = 0;
   if (n <= 1) {
-    device = devices[0];
     LOG(INFO) << "Only one MYNT EYE device, select index: 0";
   } else {
     while (true) {
-      std::size_t i;
       LOG(INFO) << "There are " << n << " MYNT EYE devices, select index: ";
-      std::cin >> i;
-      if (i >= n) {
+      std::cin >> index;
+      if (index >= n) {
         LOG(WARNING) << "Index out of range :(";
         continue;
       }
-      device = devices[i];
       break;
     }
   }
 
+  // Only the selected device is opened
+  auto &&device = context.Open(index);
+  if (device) {
+    LOG(INFO) << "Selected device, name: " << device->GetInfo(Info::DEVICE_NAME)
+              << ", sn: " << device->GetInfo(Info::SERIAL_NUMBER);
+  }
   return device;
 }
 
@@ -0,0 +1,146 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef MYNTEYE_UTIL_ENUM_MAP_H_
+#define MYNTEYE_UTIL_ENUM_MAP_H_
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <map>
+
+#include "mynteye/mynteye.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+// Map keyed by an enum class with the LAST guard, as a dense array indexed
+// by the enum, so that lookups neither search nor allocate. Iterates the
+// present keys in order, like std::map.
+template <class E, class T>
+class EnumMap {
+ public:
+  static constexpr std::size_t SIZE = static_cast<std::size_t>(E::LAST);
+
+  template <class M, class V>
+  class basic_iterator {
+   public:
+    struct value_type {
+      E first;
+      V &second;
+    };
+
+    basic_iterator(M *map, std::size_t i) : map_(map), i_(i) {
+      skip();
+    }
+
+    value_type operator*() const {
+      return {static_cast<E>(i_), map_->values_[i_]};
+    }
+
+    basic_iterator &operator++() {
+      ++i_;
+      skip();
+      return *this;
+    }
+
+    bool operator!=(const basic_iterator &other) const {
+      return i_ != other.i_;
+    }
+
+   private:
+    void skip() {
+      while (i_ < SIZE && !map_->present_[i_])
+        ++i_;
+    }
+
+    M *map_;
+    std::size_t i_;
+  };
+
+  using iterator = basic_iterator<EnumMap, T>;
+  using const_iterator = basic_iterator<const EnumMap, const T>;
+
+  EnumMap() : present_{} {}
+
+  explicit EnumMap(const std::map<E, T> &map) : EnumMap() {
+    for (auto &&it : map) {
+      (*this)[it.first] = it.second;
+    }
+  }
+
+  iterator begin() {
+    return iterator(this, 0);
+  }
+  iterator end() {
+    return iterator(this, SIZE);
+  }
+  const_iterator begin() const {
+    return const_iterator(this, 0);
+  }
+  const_iterator end() const {
+    return const_iterator(this, SIZE);
+  }
+
+  std::size_t count(E key) const {
+    std::size_t i = index(key);
+    return i < SIZE && present_[i] ? 1 : 0;
+  }
+
+  // Inserts the key if not present, the key must be less than LAST
+  T &operator[](E key) {
+    std::size_t i = index(key);
+    present_[i] = true;
+    return values_[i];
+  }
+
+  // The key must be present
+  const T &at(E key) const {
+    return values_[index(key)];
+  }
+
+  // Returns null if not present
+  T *find(E key) {
+    return count(key) ? &values_[index(key)] : nullptr;
+  }
+  const T *find(E key) const {
+    return count(key) ? &values_[index(key)] : nullptr;
+  }
+
+  void erase(E key) {
+    if (count(key)) {
+      present_[index(key)] = false;
+      values_[index(key)] = T();
+    }
+  }
+
+  void clear() {
+    for (std::size_t i = 0; i < SIZE; i++) {
+      if (present_[i]) {
+        present_[i] = false;
+        values_[i] = T();
+      }
+    }
+  }
+
+ private:
+  static std::size_t index(E key) {
+    return static_cast<std::size_t>(key);
+  }
+
+  std::array<T, SIZE> values_;
+  std::array<bool, SIZE> present_;
+};
+
+MYNTEYE_END_NAMESPACE
+
+#endif  // MYNTEYE_UTIL_ENUM_MAP_H_
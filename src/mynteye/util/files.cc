@@ -57,7 +57,8 @@ bool mkdir(const std::string &path) {
   if (size <= 0)
     return false;
   std::string p{dirs[0]};
-  if (!_mkdir(p))
+  // empty if the path is absolute
+  if (!p.empty() && !_mkdir(p))
     return false;
   for (std::size_t i = 1; i < size; i++) {
     p.append(MYNTEYE_OS_SEP).append(dirs[i]);
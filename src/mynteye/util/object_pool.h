@@ -0,0 +1,95 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef MYNTEYE_UTIL_OBJECT_POOL_H_
+#define MYNTEYE_UTIL_OBJECT_POOL_H_
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "mynteye/mynteye.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+// Fixed set of shared objects created upfront, an object is free to acquire
+// again once all the others released it, so that no allocation is needed.
+// Acquire from one thread, release from any.
+template <class T>
+class ObjectPool {
+ public:
+  // index: index of the object in pool, or the pool size if out of pool
+  using factory_t = std::function<std::shared_ptr<T>(std::size_t index)>;
+
+  ObjectPool(std::size_t size, factory_t factory)
+      : factory_(std::move(factory)), next_(0), hits_(0), misses_(0) {
+    objects_.reserve(size);
+    for (std::size_t i = 0; i < size; i++) {
+      objects_.push_back(factory_(i));
+    }
+  }
+
+  ObjectPool(const ObjectPool &) = delete;
+  ObjectPool &operator=(const ObjectPool &) = delete;
+
+  std::size_t size() const {
+    return objects_.size();
+  }
+
+  // Returns a free one, or a new one out of pool if none is free
+  std::shared_ptr<T> Acquire() {
+    std::size_t n = objects_.size();
+    for (std::size_t k = 0; k < n; k++) {
+      auto &&object = objects_[next_];
+      next_ = (next_ + 1) % n;
+      if (object.use_count() == 1) {
+        // see what the last owner did before releasing
+        std::atomic_thread_fence(std::memory_order_acquire);
+        ++hits_;
+        return object;
+      }
+    }
+    ++misses_;
+    return factory_(n);
+  }
+
+  std::uint64_t hits() const {
+    return hits_;
+  }
+
+  std::uint64_t misses() const {
+    return misses_;
+  }
+
+  void ResetStats() {
+    hits_ = 0;
+    misses_ = 0;
+  }
+
+ private:
+  factory_t factory_;
+  std::vector<std::shared_ptr<T>> objects_;
+  std::size_t next_;
+
+  std::atomic<std::uint64_t> hits_;
+  std::atomic<std::uint64_t> misses_;
+};
+
+MYNTEYE_END_NAMESPACE
+
+#endif  // MYNTEYE_UTIL_OBJECT_POOL_H_
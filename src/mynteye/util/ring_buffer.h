@@ -0,0 +1,141 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef MYNTEYE_UTIL_RING_BUFFER_H_
+#define MYNTEYE_UTIL_RING_BUFFER_H_
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "mynteye/mynteye.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+// Fixed capacity lock free queue with preallocated slots, safe for multiple
+// producers and consumers. Each slot has a sequence telling whether it is
+// ready to push (2 * pos) or pop (2 * pos + 1) at a position, so that no one
+// waits on others. The two are told apart even if the capacity is 1.
+template <class T>
+class RingBuffer {
+ public:
+  explicit RingBuffer(std::size_t capacity)
+      : capacity_(capacity > 0 ? capacity : 1),
+        slots_(new Slot[capacity_]),
+        head_(0),
+        tail_(0) {
+    for (std::size_t i = 0; i < capacity_; i++) {
+      slots_[i].sequence.store(2 * i, std::memory_order_relaxed);
+    }
+  }
+
+  RingBuffer(const RingBuffer &) = delete;
+  RingBuffer &operator=(const RingBuffer &) = delete;
+
+  std::size_t capacity() const {
+    return capacity_;
+  }
+
+  // Approximate if pushed or popped concurrently
+  std::size_t size() const {
+    std::size_t head = head_.load(std::memory_order_acquire);
+    std::size_t tail = tail_.load(std::memory_order_acquire);
+    return head > tail ? head - tail : 0;
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  // Returns false if full
+  bool TryPush(T value) {
+    Slot *slot;
+    std::size_t pos = head_.load(std::memory_order_relaxed);
+    while (true) {
+      slot = &slots_[pos % capacity_];
+      std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq - 2 * pos);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1,
+                std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+    slot->value = std::move(value);
+    slot->sequence.store(2 * pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Returns false if empty
+  bool TryPop(T *value) {
+    Slot *slot;
+    std::size_t pos = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      slot = &slots_[pos % capacity_];
+      std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq - (2 * pos + 1));
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1,
+                std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+    if (value)
+      *value = std::move(slot->value);
+    slot->value = T();  // release what it holds now
+    slot->sequence.store(2 * (pos + capacity_), std::memory_order_release);
+    return true;
+  }
+
+  // Push and drop the oldest ones if full, returns the count dropped.
+  // dropped: the last dropped one, if not null
+  std::size_t PushOverwrite(T value, T *dropped = nullptr) {
+    std::size_t count = 0;
+    while (!TryPush(value)) {
+      if (TryPop(dropped))
+        ++count;
+    }
+    return count;
+  }
+
+  void Clear() {
+    while (TryPop(nullptr)) {}
+  }
+
+ private:
+  struct Slot {
+    std::atomic<std::size_t> sequence;
+    T value;
+  };
+
+  const std::size_t capacity_;
+  std::unique_ptr<Slot[]> slots_;
+
+  // Positions of producers and consumers, on their own cache lines
+  alignas(64) std::atomic<std::size_t> head_;
+  alignas(64) std::atomic<std::size_t> tail_;
+};
+
+MYNTEYE_END_NAMESPACE
+
+#endif  // MYNTEYE_UTIL_RING_BUFFER_H_
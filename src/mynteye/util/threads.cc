@@ -0,0 +1,279 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "mynteye/util/threads.h"
+
+#if defined(MYNTEYE_OS_LINUX)
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#elif defined(MYNTEYE_OS_MAC)
+#include <pthread.h>
+#elif defined(MYNTEYE_OS_WIN)
+#include <windows.h>
+#endif
+
+#include <array>
+#include <mutex>
+
+#include "mynteye/logger.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+namespace threads {
+
+namespace {
+
+struct thread_entry {
+  Role role;
+  std::string name;
+  std::uint64_t cpu_time;  // Of the exited threads
+  bool alive;
+#if defined(MYNTEYE_OS_LINUX)
+  bool has_clock;
+  clockid_t clock;  // Cpu clock of the alive thread
+#endif
+};
+
+struct registry {
+  std::mutex mtx;
+  std::array<Policy, static_cast<std::size_t>(Role::LAST)> policies;
+  std::vector<thread_entry> entries;
+};
+
+registry &get_registry() {
+  static registry r;
+  return r;
+}
+
+// Cpu time of the current thread, in us
+std::uint64_t current_cpu_time() {
+#if defined(MYNTEYE_OS_LINUX)
+  timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+    return 0;
+  return ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+#elif defined(MYNTEYE_OS_WIN)
+  FILETIME creation, exit, kernel, user;
+  if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+    return 0;
+  auto &&to_us = [](const FILETIME &t) {
+    return ((static_cast<std::uint64_t>(t.dwHighDateTime) << 32) |
+            t.dwLowDateTime) / 10;
+  };
+  return to_us(kernel) + to_us(user);
+#else
+  return 0;
+#endif
+}
+
+#if defined(MYNTEYE_OS_LINUX) || defined(MYNTEYE_OS_WIN)
+// Whether the cpu index is in the affinity mask of the platform
+bool is_valid_cpu(int cpu) {
+#if defined(MYNTEYE_OS_LINUX)
+  return cpu >= 0 && cpu < CPU_SETSIZE;
+#else
+  return cpu >= 0 && cpu < static_cast<int>(sizeof(DWORD_PTR) * 8);
+#endif
+}
+#endif
+
+void apply_policy(const Policy &policy, const std::string &name) {
+#if defined(MYNTEYE_OS_LINUX)
+  // The name is limited to 16 characters, including the terminating null
+  pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+
+  if (!policy.cpus.empty()) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (auto &&cpu : policy.cpus) {
+      if (is_valid_cpu(cpu)) {
+        CPU_SET(cpu, &cpuset);
+      } else {
+        LOG(WARNING) << "Invalid cpu " << cpu << " of thread " << name;
+      }
+    }
+    int ret = CPU_COUNT(&cpuset) == 0 ? EINVAL :
+        pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+    if (ret != 0) {
+      LOG(WARNING) << "Set affinity of thread " << name
+                   << " failed: " << strerror(ret);
+    }
+  }
+
+  sched_param param;
+  memset(&param, 0, sizeof(param));
+  if (policy.scheduler == Scheduler::FIFO) {
+    param.sched_priority = policy.priority;
+    int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (ret != 0) {
+      LOG(WARNING) << "Set SCHED_FIFO priority " << policy.priority
+                   << " of thread " << name << " failed: " << strerror(ret);
+    }
+  } else if (policy.nice != 0) {
+    // Nice value is per thread on linux, as the thread is a process
+    if (setpriority(PRIO_PROCESS, syscall(SYS_gettid), policy.nice) != 0) {
+      LOG(WARNING) << "Set nice " << policy.nice << " of thread " << name
+                   << " failed: " << strerror(errno);
+    }
+  }
+#elif defined(MYNTEYE_OS_WIN)
+  if (!policy.cpus.empty()) {
+    DWORD_PTR mask = 0;
+    for (auto &&cpu : policy.cpus) {
+      if (is_valid_cpu(cpu)) {
+        mask |= DWORD_PTR(1) << cpu;
+      } else {
+        LOG(WARNING) << "Invalid cpu " << cpu << " of thread " << name;
+      }
+    }
+    if (mask == 0 || SetThreadAffinityMask(GetCurrentThread(), mask) == 0)
+      LOG(WARNING) << "Set affinity of thread " << name << " failed";
+  }
+  if (policy.scheduler == Scheduler::FIFO) {
+    if (!SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+      LOG(WARNING) << "Set priority of thread " << name << " failed";
+  }
+#elif defined(MYNTEYE_OS_MAC)
+  pthread_setname_np(name.c_str());
+  if (!policy.cpus.empty() || policy.scheduler != Scheduler::OTHER ||
+      policy.nice != 0) {
+    LOG(WARNING) << "Set policy of thread " << name
+                 << " failed: not supported on this platform";
+  }
+#else
+  MYNTEYE_UNUSED(policy)
+  MYNTEYE_UNUSED(name)
+#endif
+}
+
+}  // namespace
+
+bool set_affinity(std::thread &thread, int cpu) {  // NOLINT
+  if (!thread.joinable()) {
+    LOG(WARNING) << __func__ << " failed: thread is not running";
+    return false;
+  }
+#if defined(MYNTEYE_OS_LINUX)
+  if (cpu >= CPU_SETSIZE) {
+    LOG(WARNING) << __func__ << " failed: invalid cpu " << cpu;
+    return false;
+  }
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  if (cpu < 0) {
+    for (int i = 0, n = std::thread::hardware_concurrency();
+        i < n && i < CPU_SETSIZE; i++) {
+      CPU_SET(i, &cpuset);
+    }
+  } else {
+    CPU_SET(cpu, &cpuset);
+  }
+  int ret = pthread_setaffinity_np(
+      thread.native_handle(), sizeof(cpu_set_t), &cpuset);
+  if (ret != 0) {
+    LOG(WARNING) << __func__ << " to cpu " << cpu << " failed: "
+                 << strerror(ret);
+    return false;
+  }
+  return true;
+#elif defined(MYNTEYE_OS_WIN)
+  if (cpu >= static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+    LOG(WARNING) << __func__ << " failed: invalid cpu " << cpu;
+    return false;
+  }
+  DWORD_PTR mask = cpu < 0 ? ~DWORD_PTR(0) : (DWORD_PTR(1) << cpu);
+  if (SetThreadAffinityMask(thread.native_handle(), mask) == 0) {
+    LOG(WARNING) << __func__ << " to cpu " << cpu << " failed";
+    return false;
+  }
+  return true;
+#else
+  LOG(WARNING) << __func__ << " failed: not supported on this platform";
+  return false;
+#endif
+}
+
+void set_policy(Role role, const Policy &policy) {
+  auto &&r = get_registry();
+  std::lock_guard<std::mutex> _(r.mtx);
+  r.policies[static_cast<std::size_t>(role)] = policy;
+}
+
+Policy get_policy(Role role) {
+  auto &&r = get_registry();
+  std::lock_guard<std::mutex> _(r.mtx);
+  return r.policies[static_cast<std::size_t>(role)];
+}
+
+std::vector<CpuTime> get_cpu_times() {
+  auto &&r = get_registry();
+  std::lock_guard<std::mutex> _(r.mtx);
+  std::vector<CpuTime> times;
+  for (auto &&entry : r.entries) {
+    std::uint64_t cpu_time = entry.cpu_time;
+#if defined(MYNTEYE_OS_LINUX)
+    // The clock is valid as the thread could not exit while locked
+    timespec ts;
+    if (entry.alive && entry.has_clock && clock_gettime(entry.clock, &ts) == 0)
+      cpu_time += ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+#endif
+    times.push_back({entry.role, entry.name, cpu_time, entry.alive});
+  }
+  return times;
+}
+
+Scope::Scope(Role role, const std::string &name) {
+  auto &&policy = get_policy(role);
+  auto &&full_name = policy.name + name;
+  apply_policy(policy, full_name);
+
+  auto &&r = get_registry();
+  std::lock_guard<std::mutex> _(r.mtx);
+  // Reuse the entry of exited threads of the same name
+  for (index_ = 0; index_ < r.entries.size(); index_++) {
+    auto &&entry = r.entries[index_];
+    if (!entry.alive && entry.role == role && entry.name == full_name)
+      break;
+  }
+  if (index_ == r.entries.size()) {
+    thread_entry entry;
+    entry.role = role;
+    entry.name = full_name;
+    entry.cpu_time = 0;
+    r.entries.push_back(entry);
+  }
+  auto &&entry = r.entries[index_];
+  entry.alive = true;
+#if defined(MYNTEYE_OS_LINUX)
+  entry.has_clock = pthread_getcpuclockid(pthread_self(), &entry.clock) == 0;
+#endif
+}
+
+Scope::~Scope() {
+  auto &&cpu_time = current_cpu_time();
+  auto &&r = get_registry();
+  std::lock_guard<std::mutex> _(r.mtx);
+  auto &&entry = r.entries[index_];
+  entry.cpu_time += cpu_time;
+  entry.alive = false;
+}
+
+}  // namespace threads
+
+MYNTEYE_END_NAMESPACE
@@ -0,0 +1,385 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "mynteye/uvc/linux/uvc-replay.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+#include <utility>
+
+#include "mynteye/logger.h"
+#include "mynteye/util/files.h"
+#include "mynteye/util/threads.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+namespace uvc {
+
+namespace replay {
+
+namespace {
+
+const char *DEVICE_FILE = "device.txt";
+const char *FRAMES_FILE = "frames.bin";
+const char *XU_FILE = "xu.bin";
+
+std::string get_env(const char *name) {
+  const char *value = std::getenv(name);
+  return value ? value : "";
+}
+
+bool is_file(const std::string &path) {
+  struct stat st;
+  return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+void write_u16(std::ofstream &os, std::uint16_t value) {  // NOLINT
+  char bytes[2] = {
+      static_cast<char>(value & 0xFF), static_cast<char>((value >> 8) & 0xFF)};
+  os.write(bytes, 2);
+}
+
+void write_u32(std::ofstream &os, std::uint32_t value) {  // NOLINT
+  char bytes[4];
+  for (int i = 0; i < 4; i++) {
+    bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+  os.write(bytes, 4);
+}
+
+std::uint32_t read_u32(const std::uint8_t *data, std::size_t n = 4) {
+  std::uint32_t value = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    value |= static_cast<std::uint32_t>(data[i]) << (8 * i);
+  }
+  return value;
+}
+
+}  // namespace
+
+std::string get_replay_dir() {
+  return get_env("MYNTEYE_UVC_REPLAY");
+}
+
+std::string get_record_dir() {
+  return get_env("MYNTEYE_UVC_RECORD");
+}
+
+std::vector<std::string> list_device_dirs(const std::string &dir) {
+  if (is_file(dir + "/" + DEVICE_FILE)) {
+    return {dir};
+  }
+  std::vector<std::string> dirs;
+  DIR *d = opendir(dir.c_str());
+  if (!d) {
+    LOG(ERROR) << "Cannot access replay dir: " << dir;
+    return dirs;
+  }
+  while (dirent *entry = readdir(d)) {
+    std::string name = entry->d_name;
+    if (name == "." || name == "..")
+      continue;
+    if (is_file(dir + "/" + name + "/" + DEVICE_FILE))
+      dirs.push_back(dir + "/" + name);
+  }
+  closedir(d);
+  std::sort(dirs.begin(), dirs.end());
+  return dirs;
+}
+
+bool read_device_info(
+    const std::string &dir, std::string *name, int *vid, int *pid) {
+  std::ifstream info(dir + "/" + DEVICE_FILE);
+  if (!info)
+    return false;
+  std::string line;
+  while (std::getline(info, line)) {
+    auto pos = line.find('=');
+    if (pos == std::string::npos)
+      continue;
+    auto key = line.substr(0, pos);
+    auto value = line.substr(pos + 1);
+    if (key == "name") {
+      *name = value;
+    } else if (key == "vid") {
+      std::istringstream(value) >> *vid;
+    } else if (key == "pid") {
+      std::istringstream(value) >> *pid;
+    }
+  }
+  return true;
+}
+
+// recorder
+
+recorder::recorder(
+    const std::string &dir, const std::string &name, int vid, int pid) {
+  if (!files::mkdir(dir)) {
+    LOG(ERROR) << "Cannot create record dir: " << dir;
+  }
+  std::ofstream info(dir + "/" + DEVICE_FILE);
+  info << "name=" << name << std::endl
+       << "vid=" << vid << std::endl
+       << "pid=" << pid << std::endl;
+  frames_.open(dir + "/" + FRAMES_FILE, std::ios::binary);
+  xu_.open(dir + "/" + XU_FILE, std::ios::binary);
+  VLOG(2) << "Record device " << name << " to " << dir;
+}
+
+recorder::~recorder() {
+  VLOG(2) << __func__;
+}
+
+void recorder::record_frame(const void *data, std::uint32_t size) {
+  std::lock_guard<std::mutex> _(mtx_);
+  write_u32(frames_, size);
+  frames_.write(static_cast<const char *>(data), size);
+}
+
+void recorder::record_xu(
+    std::uint8_t selector, xu_query query, std::uint16_t size,
+    const std::uint8_t *data) {
+  std::lock_guard<std::mutex> _(mtx_);
+  if (query == XU_QUERY_SET) {
+    keys_[selector] = size > 0 ? data[0] : 0;
+    return;
+  }
+  xu_.put(static_cast<char>(selector));
+  xu_.put(static_cast<char>(query));
+  xu_.put(static_cast<char>(keys_[selector]));
+  write_u16(xu_, size);
+  xu_.write(reinterpret_cast<const char *>(data), size);
+  xu_.flush();
+}
+
+// device
+
+struct frames_mapping {
+  void *addr = MAP_FAILED;
+  std::size_t length = 0;
+  std::vector<std::pair<std::uint8_t *, std::uint32_t>> frames;
+
+  explicit frames_mapping(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      LOG(WARNING) << "Cannot open replay frames: " << path;
+      return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      length = st.st_size;
+      // Private writable mapping, so that consumers could modify the frames
+      addr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED)
+        LOG(WARNING) << "Cannot map replay frames: " << path;
+    }
+    close(fd);
+    if (addr == MAP_FAILED)
+      return;
+
+    auto data = static_cast<std::uint8_t *>(addr);
+    std::size_t i = 0;
+    while (i + 4 <= length) {
+      std::uint32_t size = read_u32(data + i);
+      if (i + 4 + size > length) {
+        LOG(WARNING) << "Replay frames are truncated: " << path;
+        break;
+      }
+      frames.push_back(std::make_pair(data + i + 4, size));
+      i += 4 + size;
+    }
+  }
+
+  ~frames_mapping() {
+    if (addr != MAP_FAILED)
+      munmap(addr, length);
+  }
+};
+
+device::device(const std::string &dir)
+    : dir(dir), vid(0), pid(0), fps_(0), callback_(nullptr),
+      streaming_(false) {
+  VLOG(2) << __func__ << ": " << dir;
+  read_device_info(dir, &name, &vid, &pid);
+  frames_ = std::make_shared<frames_mapping>(dir + "/" + FRAMES_FILE);
+  load_xu(dir + "/" + XU_FILE);
+  VLOG(2) << "Replay device " << name << ", " << frames_->frames.size()
+          << " frames, " << xu_responses_.size() << " xu requests";
+}
+
+device::~device() {
+  VLOG(2) << __func__;
+  stop_streaming();
+}
+
+void device::load_xu(const std::string &path) {
+  std::ifstream is(path, std::ios::binary);
+  std::uint8_t head[5];
+  while (is.read(reinterpret_cast<char *>(head), 5)) {
+    std::uint16_t size = read_u32(head + 3, 2);
+    std::vector<std::uint8_t> data(size);
+    if (!is.read(reinterpret_cast<char *>(data.data()), size)) {
+      LOG(WARNING) << "Replay xu responses are truncated: " << path;
+      break;
+    }
+    xu_responses_[std::make_tuple(head[0], head[1], head[2])].push_back(
+        std::move(data));
+  }
+}
+
+bool device::pu_control_range(
+    Option option, int32_t *min, int32_t *max, int32_t *def) const {
+  MYNTEYE_UNUSED(option)
+  // Not recorded, so report the widest range to accept any value
+  if (min) *min = std::numeric_limits<int32_t>::min();
+  if (max) *max = std::numeric_limits<int32_t>::max();
+  if (def) *def = 0;
+  return true;
+}
+
+bool device::pu_control_query(Option option, pu_query query, int32_t *value) {
+  CHECK_NOTNULL(value);
+  std::lock_guard<std::mutex> _(mtx_);
+  if (query == PU_QUERY_SET) {
+    pu_values_[option] = *value;
+  } else {
+    *value = pu_values_[option];
+  }
+  return true;
+}
+
+bool device::xu_control_query(
+    std::uint8_t selector, xu_query query, std::uint16_t size,
+    std::uint8_t *data) {
+  CHECK_NOTNULL(data);
+  std::lock_guard<std::mutex> _(mtx_);
+  if (query == XU_QUERY_SET) {
+    xu_keys_[selector] = size > 0 ? data[0] : 0;
+    return true;
+  }
+  auto key = std::make_tuple(
+      selector, static_cast<std::uint8_t>(query), xu_keys_[selector]);
+  auto it = xu_responses_.find(key);
+  if (it == xu_responses_.end()) {
+    VLOG(2) << "No recorded xu response of selector "
+            << static_cast<int>(selector) << ", query " << query;
+    return false;
+  }
+  // Responses are replayed in order, and loop at the end
+  auto &&cursor = xu_cursors_[key];
+  auto &&response = it->second[cursor];
+  cursor = (cursor + 1) % it->second.size();
+  std::size_t n = std::min<std::size_t>(size, response.size());
+  std::copy(response.begin(), response.begin() + n, data);
+  std::fill(data + n, data + size, 0);
+  return true;
+}
+
+void device::set_format(
+    int width, int height, int fourcc, int fps,
+    video_channel_callback callback) {
+  MYNTEYE_UNUSED(width)
+  MYNTEYE_UNUSED(height)
+  MYNTEYE_UNUSED(fourcc)
+  // Frames are replayed as recorded
+  fps_ = fps;
+  callback_ = callback;
+}
+
+void device::start_streaming(int cpu) {
+  if (!callback_) {
+    LOG(WARNING) << __func__ << " failed: video_channel_callback is empty";
+    return;
+  }
+  if (thread_.joinable()) {
+    LOG(WARNING) << __func__ << " failed: is streaming already";
+    return;
+  }
+  streaming_ = true;
+  thread_ = std::thread(&device::run, this);
+  if (cpu >= 0)
+    threads::set_affinity(thread_, cpu);
+}
+
+void device::stop_streaming() {
+  if (thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> _(mtx_);
+      streaming_ = false;
+    }
+    cv_.notify_all();
+    thread_.join();
+  }
+}
+
+void device::run() {
+  threads::Scope scope(threads::Role::CAPTURE, "replay");
+  auto frames = frames_;
+  if (frames->frames.empty()) {
+    LOG(WARNING) << "No frames to replay in " << dir;
+    return;
+  }
+
+  int fps = fps_;
+  auto &&fps_env = get_env("MYNTEYE_UVC_REPLAY_FPS");
+  if (!fps_env.empty()) {
+    fps = std::atoi(fps_env.c_str());
+  }
+  VLOG(2) << "Replay frames of " << dir << " at "
+          << (fps > 0 ? std::to_string(fps) : "max") << " fps";
+
+  using clock = std::chrono::steady_clock;
+  auto period = fps > 0 ? std::chrono::nanoseconds(1000000000 / fps)
+                        : std::chrono::nanoseconds(0);
+  auto next = clock::now();
+  std::size_t i = 0;
+  std::uint32_t sequence = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mtx_);
+      if (period.count() > 0) {
+        if (cv_.wait_until(lock, next, [this] { return !streaming_; }))
+          break;
+        next += period;
+      } else if (!streaming_) {
+        break;
+      }
+    }
+    auto &&frame = frames->frames[i];
+    frame_info info;
+    info.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+        clock::now().time_since_epoch()).count();
+    info.sequence = sequence++;
+    info.bytesused = frame.second;
+    info.dequeue_timestamp = info.timestamp;
+    // The mapping is kept alive until the continuation released
+    callback_(frame.first, info, [frames]() {});
+    i = (i + 1) % frames->frames.size();
+  }
+}
+
+}  // namespace replay
+
+}  // namespace uvc
+
+MYNTEYE_END_NAMESPACE
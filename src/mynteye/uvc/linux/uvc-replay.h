@@ -0,0 +1,139 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef MYNTEYE_UVC_LINUX_UVC_REPLAY_H_
+#define MYNTEYE_UVC_LINUX_UVC_REPLAY_H_
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "mynteye/uvc/uvc.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+namespace uvc {
+
+// Virtual devices replaying the recorded payloads, instead of v4l2.
+//
+// Set MYNTEYE_UVC_RECORD=<dir> to record each v4l2 device into <dir>/<video*>,
+// then set MYNTEYE_UVC_REPLAY=<dir> to replay them. <dir> could be one
+// recorded device, or contains many ones.
+//
+// Set MYNTEYE_UVC_REPLAY_FPS to replay at a rate other than the requested fps,
+// and 0 means as fast as possible.
+//
+// Files of a recorded device, integers in little endian:
+//   device.txt: name, vid and pid, as "key=value" lines
+//   frames.bin: raw payloads, each is u32 size then data
+//   xu.bin: xu responses, each is u8 selector, u8 query, u8 key, u16 size then
+//     data. The key is the first byte of the last set to the selector, which
+//     tells the request of the response.
+namespace replay {
+
+std::string get_replay_dir();
+std::string get_record_dir();
+
+// Devices recorded in the dir, or the dir itself
+std::vector<std::string> list_device_dirs(const std::string &dir);
+
+// Read name, vid and pid of the device recorded in the dir
+bool read_device_info(
+    const std::string &dir, std::string *name, int *vid, int *pid);
+
+class recorder {
+ public:
+  recorder(const std::string &dir, const std::string &name, int vid, int pid);
+  ~recorder();
+
+  void record_frame(const void *data, std::uint32_t size);
+  void record_xu(
+      std::uint8_t selector, xu_query query, std::uint16_t size,
+      const std::uint8_t *data);
+
+ private:
+  std::mutex mtx_;
+
+  std::ofstream frames_;
+  std::ofstream xu_;
+
+  std::map<std::uint8_t, std::uint8_t> keys_;
+};
+
+struct frames_mapping;
+
+class device {
+ public:
+  explicit device(const std::string &dir);
+  ~device();
+
+  std::string dir;
+  std::string name;
+  int vid, pid;
+
+  bool pu_control_range(
+      Option option, int32_t *min, int32_t *max, int32_t *def) const;
+  bool pu_control_query(Option option, pu_query query, int32_t *value);
+
+  bool xu_control_query(
+      std::uint8_t selector, xu_query query, std::uint16_t size,
+      std::uint8_t *data);
+
+  void set_format(
+      int width, int height, int fourcc, int fps,
+      video_channel_callback callback);
+
+  // cpu: cpu core to run the replay thread, -1 for any
+  void start_streaming(int cpu);
+  void stop_streaming();
+
+ private:
+  using xu_key_t = std::tuple<std::uint8_t, std::uint8_t, std::uint8_t>;
+  using xu_responses_t = std::vector<std::vector<std::uint8_t>>;
+
+  void load_xu(const std::string &path);
+
+  void run();
+
+  int fps_;
+  video_channel_callback callback_;
+
+  std::shared_ptr<frames_mapping> frames_;
+
+  std::map<xu_key_t, xu_responses_t> xu_responses_;
+  std::map<xu_key_t, std::size_t> xu_cursors_;
+  std::map<std::uint8_t, std::uint8_t> xu_keys_;
+
+  std::map<Option, int32_t> pu_values_;
+
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  bool streaming_;
+  std::thread thread_;
+};
+
+}  // namespace replay
+
+}  // namespace uvc
+
+MYNTEYE_END_NAMESPACE
+
+#endif  // MYNTEYE_UVC_LINUX_UVC_REPLAY_H_
@@ -19,6 +19,8 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -29,12 +31,16 @@
 #include <linux/videodev2.h>
 
 #include <chrono>
+#include <cstdlib>
 #include <fstream>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <thread>
 
 #include "mynteye/logger.h"
+#include "mynteye/util/threads.h"
+#include "mynteye/uvc/linux/uvc-replay.h"
 
 MYNTEYE_BEGIN_NAMESPACE
 
@@ -45,11 +51,9 @@ namespace uvc {
     LOG(severity) << str << " error " << errno << ", " << strerror(errno); \
   } while (0)
 
-#define NO_DATA_MAX_COUNT 200
+#define BUFFER_DEFAULT_COUNT 24
 #define LIVING_MAX_COUNT 9000
 
-int no_data_count = 0;
-int living_count = 0;
 /*
 class device_error : public std::exception {
  public:
@@ -100,6 +104,47 @@ struct buffer {
   size_t length;
 };
 
+// Capture session shared with the continuations of buffers, as they may be
+// called after the capture stopped.
+struct session {
+  std::mutex mtx;
+  int fd;
+  bool streaming;
+  std::vector<bool> queued;  // Whether each buffer is queued to the driver
+
+  session(int fd, size_t buffer_count)
+      : fd(fd), streaming(true), queued(buffer_count, true) {}
+
+  // Returns false if failed to queue the buffer
+  bool queue(v4l2_buffer *buf) {
+    std::lock_guard<std::mutex> _(mtx);
+    if (!streaming)
+      return true;
+    if (xioctl(fd, VIDIOC_QBUF, buf) < 0)
+      return false;
+    queued[buf->index] = true;
+    return true;
+  }
+
+  void dequeued(const v4l2_buffer &buf) {
+    std::lock_guard<std::mutex> _(mtx);
+    queued[buf.index] = false;
+  }
+};
+
+static std::uint64_t steady_now_us() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::shared_ptr<std::uint8_t> alloc_user_buffer(size_t length) {
+  void *ptr = nullptr;
+  if (posix_memalign(&ptr, getpagesize(), length) != 0)
+    LOG(FATAL) << "Alloc user buffer failed, length: " << length;
+  return std::shared_ptr<std::uint8_t>(
+      static_cast<std::uint8_t *>(ptr), [](std::uint8_t *p) { free(p); });
+}
+
 struct context {
   context() {
     VLOG(2) << __func__;
@@ -123,44 +168,39 @@ struct device {
   video_channel_callback callback = nullptr;
 
   bool is_capturing = false;
+  int buffer_count = BUFFER_DEFAULT_COUNT;
   std::vector<buffer> buffers;
 
-  std::thread thread;
-  volatile bool stop = false;
+  // Zero copy with user pointer buffers, instead of memory mapping
+  bool zero_copy = false;
+  std::vector<std::shared_ptr<std::uint8_t>> user_buffers;
+  std::shared_ptr<session> capture_session;
 
-  device(std::shared_ptr<context> parent, const std::string &name)
-      : parent(parent), dev_name("/dev/" + name) {
+  std::thread thread;
+  int capture_cpu = -1;  // Cpu core to run the capture thread, -1 for any
+  int living_count = 0;  // Frames since the last no data timeout
+
+  recovery_config recovery;
+  recovery_callback recovery_cb = nullptr;
+  int recovery_tier = 0;               // The last tier tried, 0 if streaming
+  std::uint64_t last_frame_time = 0;   // Dequeue time of the last frame, in us
+  int epoll_fd = -1;     // Waits on fd and stop_fd
+  int stop_fd = -1;      // Eventfd to wake up and stop the capture thread
+
+  std::shared_ptr<replay::device> replay;      // Replays instead of v4l2
+  std::shared_ptr<replay::recorder> recorder;  // Records frames and xu
+
+  device(std::shared_ptr<context> parent,
+      std::shared_ptr<replay::device> replay)
+      : parent(parent), dev_name(replay->dir), name(replay->name),
+        vid(replay->vid), pid(replay->pid), mi(0), replay(replay) {
     VLOG(2) << __func__ << ": " << dev_name;
+  }
 
-    struct stat st;
-    if (stat(dev_name.c_str(), &st) < 0) {  // file status
-      throw_error() << "Cannot identify '" << dev_name << "': " << errno << ", "
-                    << strerror(errno);
-    }
-    if (!S_ISCHR(st.st_mode)) {  // character device?
-      throw_error() << dev_name << " is no device";
-    }
-
-    if (!(std::ifstream("/sys/class/video4linux/" + name + "/name") >>
-          this->name))
-      throw_error() << "Failed to read name";
-
-    std::string modalias;
-    if (!(std::ifstream(
-              "/sys/class/video4linux/" + name + "/device/modalias") >>
-          modalias))
-      throw_error() << "Failed to read modalias";
-    if (modalias.size() < 14 || modalias.substr(0, 5) != "usb:v" ||
-        modalias[9] != 'p')
-      throw_error() << "Not a usb format modalias";
-    if (!(std::istringstream(modalias.substr(5, 4)) >> std::hex >> vid))
-      throw_error() << "Failed to read vendor ID";
-    if (!(std::istringstream(modalias.substr(10, 4)) >> std::hex >> pid))
-      throw_error() << "Failed to read product ID";
-    if (!(std::ifstream(
-              "/sys/class/video4linux/" + name + "/device/bInterfaceNumber") >>
-          std::hex >> mi))
-      throw_error() << "Failed to read interface number";
+  device(std::shared_ptr<context> parent, const device_desc &desc)
+      : parent(parent), dev_name("/dev/" + desc.video_name), name(desc.name),
+        vid(desc.vid), pid(desc.pid), mi(desc.mi) {
+    VLOG(2) << __func__ << ": " << dev_name;
 
     fd = open(dev_name.c_str(), O_RDWR | O_NONBLOCK, 0);
     if (fd < 0) {
@@ -198,12 +238,17 @@ struct device {
       }
     } else {
     }  // Errors ignored
+
+    auto &&record_dir = replay::get_record_dir();
+    if (!record_dir.empty()) {
+      recorder = std::make_shared<replay::recorder>(
+          record_dir + "/" + desc.video_name, name, vid, pid);
+    }
   }
 
   ~device() {
     VLOG(2) << __func__;
     stop_streaming();
-    no_data_count = 0;
     if (fd != -1 && close(fd) < 0) {
       LOG_ERROR(WARNING, "close");
     }
@@ -259,6 +304,24 @@ struct device {
     this->callback = callback;
   }
 
+  v4l2_memory memory() const {
+    return zero_copy ? V4L2_MEMORY_USERPTR : V4L2_MEMORY_MMAP;
+  }
+
+  v4l2_buffer make_buffer(size_t index) const {
+    v4l2_buffer buf;
+    memset(&buf, 0, sizeof(buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = memory();
+    buf.index = index;
+    if (zero_copy) {
+      buf.m.userptr = reinterpret_cast<unsigned long>(  // NOLINT
+          buffers[index].start);
+      buf.length = buffers[index].length;
+    }
+    return buf;
+  }
+
   void start_capture() {
     if (is_capturing) {
       LOG(WARNING) << "Start capture failed, is capturing already";
@@ -284,14 +347,15 @@ struct device {
     if (xioctl(fd, VIDIOC_S_PARM, &parm) < 0)
       LOG_ERROR(FATAL, "VIDIOC_S_PARM");
 
-    // Init memory mapped IO
+    // Init memory mapped or user pointer IO
     v4l2_requestbuffers req;
-    req.count = 24;
+    req.count = buffer_count;
     req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    req.memory = V4L2_MEMORY_MMAP;
+    req.memory = memory();
     if (xioctl(fd, VIDIOC_REQBUFS, &req) < 0) {
       if (errno == EINVAL)
-        LOG(FATAL) << dev_name << " does not support memory mapping";
+        LOG(FATAL) << dev_name << " does not support "
+                   << (zero_copy ? "user pointer" : "memory mapping");
       else
         LOG_ERROR(FATAL, "VIDIOC_REQBUFS");
     }
@@ -300,40 +364,45 @@ struct device {
     }
 
     buffers.resize(req.count);
-    for (size_t i = 0; i < buffers.size(); ++i) {
-      v4l2_buffer buf;
-      buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-      buf.memory = V4L2_MEMORY_MMAP;
-      buf.index = i;
-      if (xioctl(fd, VIDIOC_QUERYBUF, &buf) < 0)
-        LOG_ERROR(FATAL, "VIDIOC_QUERYBUF");
-
-      buffers[i].length = buf.length;
-      buffers[i].start = mmap(
-          NULL, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
-          buf.m.offset);
-      if (buffers[i].start == MAP_FAILED)
-        LOG_ERROR(FATAL, "mmap");
+    if (zero_copy) {
+      user_buffers.resize(req.count);
+      for (size_t i = 0; i < buffers.size(); ++i) {
+        user_buffers[i] = alloc_user_buffer(fmt.fmt.pix.sizeimage);
+        buffers[i].length = fmt.fmt.pix.sizeimage;
+        buffers[i].start = user_buffers[i].get();
+      }
+    } else {
+      for (size_t i = 0; i < buffers.size(); ++i) {
+        v4l2_buffer buf;
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (xioctl(fd, VIDIOC_QUERYBUF, &buf) < 0)
+          LOG_ERROR(FATAL, "VIDIOC_QUERYBUF");
+
+        buffers[i].length = buf.length;
+        buffers[i].start = mmap(
+            NULL, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+            buf.m.offset);
+        if (buffers[i].start == MAP_FAILED)
+          LOG_ERROR(FATAL, "mmap");
+      }
     }
 
     // Start capturing
     for (size_t i = 0; i < buffers.size(); ++i) {
-      v4l2_buffer buf;
-      buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-      buf.memory = V4L2_MEMORY_MMAP;
-      buf.index = i;
+      v4l2_buffer buf = make_buffer(i);
       if (xioctl(fd, VIDIOC_QBUF, &buf) < 0)
         LOG_ERROR(FATAL, "VIDIOC_QBUF");
     }
+    capture_session = std::make_shared<session>(fd, buffers.size());
 
     v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    for (int i = 0; i < 10; ++i) {
-      if (xioctl(fd, VIDIOC_STREAMON, &type) < 0) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-      }
+    for (int i = 0; xioctl(fd, VIDIOC_STREAMON, &type) < 0; ++i) {
+      if (i >= 10)
+        LOG_ERROR(FATAL, "VIDIOC_STREAMON");
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
-    if (xioctl(fd, VIDIOC_STREAMON, &type) < 0)
-      LOG_ERROR(FATAL, "VIDIOC_STREAMON");
 
     is_capturing = true;
   }
@@ -342,21 +411,34 @@ struct device {
     if (!is_capturing)
       return;
 
+    {
+      // The pending continuations will not queue buffers from now on
+      std::lock_guard<std::mutex> _(capture_session->mtx);
+      capture_session->streaming = false;
+    }
+    capture_session = nullptr;
+
     // Stop streamining
     v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     if (xioctl(fd, VIDIOC_STREAMOFF, &type) < 0)
       LOG_ERROR(WARNING, "VIDIOC_STREAMOFF");
 
-    for (size_t i = 0; i < buffers.size(); i++) {
-      if (munmap(buffers[i].start, buffers[i].length) < 0)
-        LOG_ERROR(WARNING, "munmap");
+    if (zero_copy) {
+      // User buffers are freed after their last continuation released
+      user_buffers.clear();
+    } else {
+      for (size_t i = 0; i < buffers.size(); i++) {
+        if (munmap(buffers[i].start, buffers[i].length) < 0)
+          LOG_ERROR(WARNING, "munmap");
+      }
     }
+    buffers.clear();
 
-    // Close memory mapped IO
+    // Close memory mapped or user pointer IO
     struct v4l2_requestbuffers req;
     req.count = 0;
     req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    req.memory = V4L2_MEMORY_MMAP;
+    req.memory = memory();
     if (xioctl(fd, VIDIOC_REQBUFS, &req) < 0) {
       if (errno == EINVAL)
         LOG(ERROR) << dev_name << " does not support memory mapping";
@@ -367,34 +449,122 @@ struct device {
     is_capturing = false;
   }
 
-  void poll() {
-    fd_set fds;
-    FD_ZERO(&fds);
-    FD_SET(fd, &fds);
+  // Restarts streaming without reopening the buffers, the buffers held by
+  // continuations are queued when they are called.
+  bool restart_streaming() {
+    std::lock_guard<std::mutex> _(capture_session->mtx);
+    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(fd, VIDIOC_STREAMOFF, &type) < 0) {
+      LOG_ERROR(WARNING, "VIDIOC_STREAMOFF");
+      return false;
+    }
+    // All buffers are dequeued by STREAMOFF, queue the ones in driver again
+    for (size_t i = 0; i < buffers.size(); ++i) {
+      if (!capture_session->queued[i])
+        continue;
+      v4l2_buffer buf = make_buffer(i);
+      if (xioctl(fd, VIDIOC_QBUF, &buf) < 0) {
+        LOG_ERROR(WARNING, "VIDIOC_QBUF");
+        return false;
+      }
+    }
+    if (xioctl(fd, VIDIOC_STREAMON, &type) < 0) {
+      LOG_ERROR(WARNING, "VIDIOC_STREAMON");
+      return false;
+    }
+    return true;
+  }
 
-    struct timeval tv = {0, 10000};
+  void recover() {
+    living_count = 0;
+    if (recovery_tier == 0 && restart_streaming()) {
+      LOG(WARNING) << "v4l2 get stream time out, restarted streaming";
+      recovery_tier = 1;
+    } else {
+      LOG(WARNING) << "v4l2 get stream time out, reopen capture";
+      stop_capture();
+      start_capture();
+      recovery_tier = 2;
+    }
+  }
 
-    if (select(fd + 1, &fds, NULL, NULL, &tv) < 0) {
+  // Returns false if woken up to stop
+  bool poll() {
+    epoll_event events[2];
+    int n = epoll_wait(epoll_fd, events, 2, recovery_tier == 1 ?
+        recovery.restart_timeout_ms : recovery.no_data_timeout_ms);
+    if (n < 0) {
       if (errno == EINTR)
-        return;
-      LOG_ERROR(FATAL, "select");
+        return true;
+      LOG_ERROR(FATAL, "epoll_wait");
     }
 
-    if (FD_ISSET(fd, &fds)) {
+    if (n == 0) {
+      recover();
+      return true;
+    }
+
+    bool readable = false;
+    for (int i = 0; i < n; ++i) {
+      if (events[i].data.fd == stop_fd)
+        return false;
+      if (events[i].data.fd == fd)
+        readable = true;
+    }
+    if (!readable)
+      return true;
+
+    // Drain all the ready buffers at once
+    while (true) {
       v4l2_buffer buf;
+      memset(&buf, 0, sizeof(buf));
       buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-      buf.memory = V4L2_MEMORY_MMAP;
+      buf.memory = memory();
       if (xioctl(fd, VIDIOC_DQBUF, &buf) < 0) {
         if (errno == EAGAIN)
-          return;
+          break;
         LOG_ERROR(FATAL, "VIDIOC_DQBUF");
       }
+      capture_session->dequeued(buf);
+
+      auto &&now = steady_now_us();
+      if (recovery_tier > 0) {
+        recovery_event event;
+        event.tier = recovery_tier;
+        event.downtime = now - last_frame_time;
+        recovery_tier = 0;
+        VLOG(2) << "v4l2 stream recovered at tier " << event.tier
+                << ", downtime " << event.downtime << " us";
+        if (recovery_cb)
+          recovery_cb(event);
+      }
+      last_frame_time = now;
 
+      if (recorder) {
+        recorder->record_frame(buffers[buf.index].start, buf.bytesused);
+      }
       if (callback) {
-        callback(buffers[buf.index].start, [buf, this]() mutable {
-          if (xioctl(fd, VIDIOC_QBUF, &buf) < 0)
-            throw_error("VIDIOC_QBUF");
-        });
+        frame_info info;
+        info.timestamp = buf.timestamp.tv_sec * 1000000ULL +
+                         buf.timestamp.tv_usec;
+        info.sequence = buf.sequence;
+        info.bytesused = buf.bytesused;
+        info.dequeue_timestamp = now;
+        auto session = capture_session;
+        if (zero_copy) {
+          // Could be called from any thread, even after the capture stopped
+          auto user_buffer = user_buffers[buf.index];
+          callback(user_buffer.get(), info,
+              [buf, user_buffer, session]() mutable {
+            if (!session->queue(&buf))
+              LOG_ERROR(WARNING, "VIDIOC_QBUF");
+          });
+        } else {
+          callback(buffers[buf.index].start, info, [buf, session]() mutable {
+            if (!session->queue(&buf))
+              throw_error("VIDIOC_QBUF");
+          });
+        }
         if (living_count < LIVING_MAX_COUNT) {
           living_count++;
         } else {
@@ -402,41 +572,64 @@ struct device {
           // LOG(INFO) << "UVC pulse detection,Please ignore.";
         }
       }
-
-      no_data_count = 0;
-    } else {
-      no_data_count++;
     }
+    return true;
+  }
 
-    if (no_data_count > NO_DATA_MAX_COUNT) {
-      no_data_count = 0;
-      living_count = 0;
-      LOG(WARNING) << __func__
-                   << " failed: v4l2 get stream time out, Try to reboot!";
-      stop_capture();
-      start_capture();
-    }
+  void open_poller() {
+    stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (stop_fd < 0)
+      LOG_ERROR(FATAL, "eventfd");
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0)
+      LOG_ERROR(FATAL, "epoll_create1");
+
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+      LOG_ERROR(FATAL, "epoll_ctl");
+    event.data.fd = stop_fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &event) < 0)
+      LOG_ERROR(FATAL, "epoll_ctl");
   }
 
-  void start_streaming() {
+  void close_poller() {
+    if (epoll_fd != -1 && close(epoll_fd) < 0)
+      LOG_ERROR(WARNING, "close");
+    if (stop_fd != -1 && close(stop_fd) < 0)
+      LOG_ERROR(WARNING, "close");
+    epoll_fd = -1;
+    stop_fd = -1;
+  }
+
+  void start_streaming(int num_buffers) {
     if (!callback) {
       LOG(WARNING) << __func__ << " failed: video_channel_callback is empty";
       return;
     }
 
+    buffer_count = num_buffers > 0 ? num_buffers : BUFFER_DEFAULT_COUNT;
+    recovery_tier = 0;
+    last_frame_time = steady_now_us();
     start_capture();
+    open_poller();
 
     thread = std::thread([this]() {
-      while (!stop)
-        poll();
+      threads::Scope scope(threads::Role::CAPTURE, "capture");
+      while (poll()) {}
     });
+    if (capture_cpu >= 0)
+      threads::set_affinity(thread, capture_cpu);
   }
 
   void stop_streaming() {
     if (thread.joinable()) {
-      stop = true;
+      std::uint64_t value = 1;
+      if (write(stop_fd, &value, sizeof(value)) < 0)
+        LOG_ERROR(WARNING, "write");
       thread.join();
-      stop = false;
+      close_poller();
 
       stop_capture();
     }
@@ -450,6 +643,71 @@ std::shared_ptr<context> create_context() {
 std::vector<std::shared_ptr<device>> query_devices(
     std::shared_ptr<context> context) {
   std::vector<std::shared_ptr<device>> devices;
+  for (auto &&desc : query_device_descs(context)) {
+    auto &&dev = open_device(context, desc);
+    if (dev)
+      devices.push_back(dev);
+  }
+  return devices;
+}
+
+// Reads the description of a video node from sysfs only
+static device_desc read_device_desc(const std::string &name) {
+  device_desc desc;
+  desc.video_name = name;
+
+  std::string dev_name = "/dev/" + name;
+  struct stat st;
+  if (stat(dev_name.c_str(), &st) < 0) {  // file status
+    throw_error() << "Cannot identify '" << dev_name << "': " << errno << ", "
+                  << strerror(errno);
+  }
+  if (!S_ISCHR(st.st_mode)) {  // character device?
+    throw_error() << dev_name << " is no device";
+  }
+
+  std::string sys_path = "/sys/class/video4linux/" + name;
+  if (!(std::ifstream(sys_path + "/name") >> desc.name))
+    throw_error() << "Failed to read name";
+
+  std::string modalias;
+  if (!(std::ifstream(sys_path + "/device/modalias") >> modalias))
+    throw_error() << "Failed to read modalias";
+  if (modalias.size() < 14 || modalias.substr(0, 5) != "usb:v" ||
+      modalias[9] != 'p')
+    throw_error() << "Not a usb format modalias";
+  if (!(std::istringstream(modalias.substr(5, 4)) >> std::hex >> desc.vid))
+    throw_error() << "Failed to read vendor ID";
+  if (!(std::istringstream(modalias.substr(10, 4)) >> std::hex >> desc.pid))
+    throw_error() << "Failed to read product ID";
+  if (!(std::ifstream(sys_path + "/device/bInterfaceNumber") >> std::hex >>
+        desc.mi))
+    throw_error() << "Failed to read interface number";
+
+  // The parent of the usb interface is the usb device, named by its port path
+  char usb_path[PATH_MAX];
+  if (realpath((sys_path + "/device/..").c_str(), usb_path)) {
+    std::string path = usb_path;
+    desc.bus_path = path.substr(path.find_last_of('/') + 1);
+    std::ifstream(path + "/serial") >> desc.serial;
+  }
+  return desc;
+}
+
+std::vector<device_desc> query_device_descs(std::shared_ptr<context> context) {
+  MYNTEYE_UNUSED(context)
+  std::vector<device_desc> descs;
+
+  auto &&replay_dir = replay::get_replay_dir();
+  if (!replay_dir.empty()) {
+    for (auto &&dir : replay::list_device_dirs(replay_dir)) {
+      device_desc desc;
+      desc.video_name = dir;
+      replay::read_device_info(dir, &desc.name, &desc.vid, &desc.pid);
+      descs.push_back(desc);
+    }
+    return descs;
+  }
 
   DIR *dir = opendir("/sys/class/video4linux");
   if (!dir)
@@ -471,14 +729,30 @@ std::vector<std::shared_ptr<device>> query_devices(
     }
 
     try {
-      devices.push_back(std::make_shared<device>(context, name));
+      descs.push_back(read_device_desc(name));
     } catch (const std::exception &e) {
       VLOG(2) << "Not a USB video device: " << e.what();
     }
   }
   closedir(dir);
 
-  return devices;
+  return descs;
+}
+
+std::shared_ptr<device> open_device(
+    std::shared_ptr<context> context, const device_desc &desc) {
+  if (desc.opened)
+    return desc.opened;
+  if (!replay::get_replay_dir().empty()) {
+    return std::make_shared<device>(
+        context, std::make_shared<replay::device>(desc.video_name));
+  }
+  try {
+    return std::make_shared<device>(context, desc);
+  } catch (const std::exception &e) {
+    LOG(WARNING) << "Cannot open " << desc.video_name << ": " << e.what();
+    return nullptr;
+  }
 }
 
 std::string get_name(const device &device) {
@@ -513,11 +787,15 @@ static uint32_t get_cid(Option option) {
 bool pu_control_range(
     const device &device, Option option, int32_t *min, int32_t *max,
     int32_t *def) {
+  if (device.replay)
+    return device.replay->pu_control_range(option, min, max, def);
   return device.pu_control_range(get_cid(option), min, max, def);
 }
 
 bool pu_control_query(
     const device &device, Option option, pu_query query, int32_t *value) {
+  if (device.replay)
+    return device.replay->pu_control_query(option, query, value);
   int code;
   switch (query) {
     case PU_QUERY_SET:
@@ -569,6 +847,8 @@ bool xu_control_range(
 bool xu_control_query(
     const device &device, const xu &xu, uint8_t selector, xu_query query,
     uint16_t size, uint8_t *data) {
+  if (device.replay)
+    return device.replay->xu_control_query(selector, query, size, data);
   uint8_t code;
   switch (query) {
     case XU_QUERY_SET:
@@ -590,20 +870,62 @@ bool xu_control_query(
       LOG(ERROR) << "xu_control_query request code is unaccepted";
       return false;
   }
-  return device.xu_control_query(xu, selector, code, size, data);
+  if (!device.xu_control_query(xu, selector, code, size, data))
+    return false;
+  if (device.recorder)
+    device.recorder->record_xu(selector, query, size, data);
+  return true;
 }
 
 void set_device_mode(
     device &device, int width, int height, int fourcc, int fps,  // NOLINT
     video_channel_callback callback) {
+  if (device.replay) {
+    device.replay->set_format(width, height, fourcc, fps, callback);
+    return;
+  }
   device.set_format(width, height, fourcc, fps, callback);
 }
 
-void start_streaming(device &device, int /*num_transfer_bufs*/) {  // NOLINT
-  device.start_streaming();
+bool set_zero_copy(device &device, bool enabled) {  // NOLINT
+  if (device.is_capturing) {
+    LOG(WARNING) << __func__ << " failed: could not change while capturing";
+    return false;
+  }
+  device.zero_copy = enabled;
+  return true;
+}
+
+bool set_recovery(
+    device &device, const recovery_config &config,  // NOLINT
+    recovery_callback callback) {
+  if (device.is_capturing) {
+    LOG(WARNING) << __func__ << " failed: could not change while capturing";
+    return false;
+  }
+  device.recovery = config;
+  device.recovery_cb = callback;
+  return true;
+}
+
+bool set_capture_affinity(device &device, int cpu) {  // NOLINT
+  device.capture_cpu = cpu;
+  return true;
+}
+
+void start_streaming(device &device, int num_transfer_bufs) {  // NOLINT
+  if (device.replay) {
+    device.replay->start_streaming(device.capture_cpu);
+    return;
+  }
+  device.start_streaming(num_transfer_bufs);
 }
 
 void stop_streaming(device &device) {  // NOLINT
+  if (device.replay) {
+    device.replay->stop_streaming();
+    return;
+  }
   device.stop_streaming();
 }
 
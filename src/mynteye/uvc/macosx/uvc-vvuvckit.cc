@@ -224,7 +224,12 @@ struct device : public AVfoundationCamera{
       camera_buffer = getFrame();
       if (camera_buffer != NULL) {
         if (callback) {
-          callback(camera_buffer, [this]() mutable {
+          frame_info info;
+          info.dequeue_timestamp =
+              std::chrono::duration_cast<std::chrono::microseconds>(
+                  std::chrono::steady_clock::now().time_since_epoch())
+                  .count();
+          callback(camera_buffer, info, [this]() mutable {
             // todo
           });
         }
@@ -290,6 +295,27 @@ MYNTEYE_API std::vector<std::shared_ptr<device>> query_devices(
   return devices;
 }
 
+MYNTEYE_API std::vector<device_desc> query_device_descs(
+    std::shared_ptr<context> context) {
+  // Devices are opened while enumerating
+  std::vector<device_desc> descs;
+  for (auto &&dev : query_devices(context)) {
+    device_desc desc;
+    desc.name = dev->get_name();
+    desc.vid = dev->get_vendor_id();
+    desc.pid = dev->get_product_id();
+    desc.video_name = dev->get_video_name();
+    desc.opened = dev;
+    descs.push_back(desc);
+  }
+  return descs;
+}
+
+MYNTEYE_API std::shared_ptr<device> open_device(
+    std::shared_ptr<context> context, const device_desc &desc) {
+  return desc.opened;
+}
+
 // Static device properties
 MYNTEYE_API std::string get_name(const device &device) {
   return device.get_name();
@@ -419,6 +445,21 @@ MYNTEYE_API void set_device_mode(
   }
   device.callback = callback;
 }
+MYNTEYE_API bool set_zero_copy(device &device, bool enabled) { // NOLINT
+  if (enabled)
+    LOG(WARNING) << __func__ << " failed: not supported on this platform";
+  return !enabled;
+}
+MYNTEYE_API bool set_recovery(
+    device &device, const recovery_config &config, // NOLINT
+    recovery_callback callback) {
+  LOG(WARNING) << __func__ << " failed: not supported on this platform";
+  return false;
+}
+MYNTEYE_API bool set_capture_affinity(device &device, int cpu) { // NOLINT
+  LOG(WARNING) << __func__ << " failed: not supported on this platform";
+  return false;
+}
 MYNTEYE_API void start_streaming(device &device, int num_transfer_bufs) { // NOLINT
   device.start_streaming();
 }
@@ -67,6 +67,24 @@ MYNTEYE_API std::shared_ptr<context> create_context();
 MYNTEYE_API std::vector<std::shared_ptr<device>> query_devices(
     std::shared_ptr<context> context);
 
+// Lightweight description of a device, enumerated without opening it
+struct MYNTEYE_API device_desc {
+  std::string name;        // Device description name
+  int vid = 0, pid = 0;    // Vendor ID, product ID
+  int mi = 0;              // Multiple interface index
+  std::string serial;      // Serial number of the usb device, if any
+  std::string bus_path;    // Usb port path, such as "1-2.1"
+  std::string video_name;  // Name of the video node, such as "video0"
+  // Opened already by the backends which could not open later
+  std::shared_ptr<device> opened;
+};
+
+MYNTEYE_API std::vector<device_desc> query_device_descs(
+    std::shared_ptr<context> context);
+// Open the device described, nullptr if failed
+MYNTEYE_API std::shared_ptr<device> open_device(
+    std::shared_ptr<context> context, const device_desc &desc);
+
 // Static device properties
 MYNTEYE_API std::string get_name(const device &device);
 MYNTEYE_API int get_vendor_id(const device &device);
@@ -93,12 +111,44 @@ MYNTEYE_API bool xu_control_query(  // XU_QUERY_SET, XU_QUERY_GET
     uint16_t size, uint8_t *data);
 
 // Control streaming
-typedef std::function<void(const void *frame,
+
+// Info of each captured frame, zero if unknown
+struct MYNTEYE_API frame_info {
+  std::uint64_t timestamp = 0;  // Capture time by driver, in microseconds
+  std::uint32_t sequence = 0;   // Sequence number by driver
+  std::uint32_t bytesused = 0;  // Bytes of the frame data
+  // Dequeue time by host, in microseconds of steady clock
+  std::uint64_t dequeue_timestamp = 0;
+};
+
+typedef std::function<void(const void *frame, const frame_info &info,
     std::function<void()> continuation)> video_channel_callback;
 
 MYNTEYE_API void set_device_mode(
     device &device, int width, int height, int fourcc, int fps,  // NOLINT
     video_channel_callback callback);
+// enabled: frames stay valid until their continuation called, even after
+// stop_streaming, so that they could be shared without copy
+MYNTEYE_API bool set_zero_copy(device &device, bool enabled);  // NOLINT
+// Thresholds to recover streaming when no data, in milliseconds
+struct MYNTEYE_API recovery_config {
+  int no_data_timeout_ms = 2000;  // To restart streaming in place, as tier 1
+  int restart_timeout_ms = 200;   // To reopen the capture after tier 1, tier 2
+};
+
+struct MYNTEYE_API recovery_event {
+  int tier = 0;                // The last tier tried
+  std::uint64_t downtime = 0;  // From the last frame to recovered, in us
+};
+
+typedef std::function<void(const recovery_event &event)> recovery_callback;
+
+MYNTEYE_API bool set_recovery(
+    device &device, const recovery_config &config,  // NOLINT
+    recovery_callback callback);
+// cpu: cpu core to run the capture thread, -1 for any
+MYNTEYE_API bool set_capture_affinity(device &device, int cpu);  // NOLINT
+// num_transfer_bufs: count of capture buffers, use default if <= 0
 MYNTEYE_API void start_streaming(device &device, int num_transfer_bufs);  // NOLINT
 MYNTEYE_API void stop_streaming(device &device);                          // NOLINT
 
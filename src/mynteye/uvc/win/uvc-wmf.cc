@@ -403,7 +403,14 @@ HRESULT reader_callback::OnReadSample(HRESULT hrStatus, DWORD dwStreamIndex, DWO
           auto continuation = [buffer, this]() {
             buffer->Unlock();
           };
-          owner_ptr->callback(byte_buffer, continuation);
+          frame_info info;
+          info.timestamp = llTimestamp / 10;  // 100ns to 1us
+          info.bytesused = current_length;
+          info.dequeue_timestamp =
+              std::chrono::duration_cast<std::chrono::microseconds>(
+                  std::chrono::steady_clock::now().time_since_epoch())
+                  .count();
+          owner_ptr->callback(byte_buffer, info, continuation);
         }
       }
     }
@@ -487,6 +494,26 @@ std::vector<std::shared_ptr<device>> query_devices(std::shared_ptr<context> cont
   return devices;
 }
 
+std::vector<device_desc> query_device_descs(std::shared_ptr<context> context) {
+  // Devices are opened while enumerating, as media sources are activated
+  std::vector<device_desc> descs;
+  for (auto &&dev : query_devices(context)) {
+    device_desc desc;
+    desc.name = dev->name;
+    desc.vid = dev->vid;
+    desc.pid = dev->pid;
+    desc.serial = dev->unique_id;
+    desc.opened = dev;
+    descs.push_back(desc);
+  }
+  return descs;
+}
+
+std::shared_ptr<device> open_device(
+    std::shared_ptr<context> context, const device_desc &desc) {
+  return desc.opened;
+}
+
 int get_vendor_id(const device &device) {
   return device.vid;
 }
@@ -771,6 +798,26 @@ void set_device_mode(device &device, int width, int height, int fourcc, int fps,
   throw_error() << "no matching media type for pixel format " << std::hex << fourcc;
 }
 
+bool set_zero_copy(device &device, bool enabled) {
+  if (enabled)
+    LOG(WARNING) << __func__ << " failed: not supported on this platform";
+  return !enabled;
+}
+
+bool set_recovery(
+    device &device, const recovery_config &config,
+    recovery_callback callback) {
+  // Streams are recovered by media foundation
+  LOG(WARNING) << __func__ << " failed: not supported on this platform";
+  return false;
+}
+
+bool set_capture_affinity(device &device, int cpu) {
+  // Samples are read on the threads of media foundation
+  LOG(WARNING) << __func__ << " failed: not supported on this platform";
+  return false;
+}
+
 void start_streaming(device &device, int num_transfer_bufs) {
   device.start_streaming();
 }
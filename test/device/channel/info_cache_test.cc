@@ -0,0 +1,133 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "mynteye/device/channel/info_cache.h"
+
+MYNTEYE_USE_NAMESPACE
+
+class InfoCacheTest : public ::testing::Test {
+ protected:
+  InfoCacheTest()
+      : dir("info_cache_test"),
+        path(dir + MYNTEYE_OS_SEP + "usb-0123-0100.bin"),
+        key("usb-0123-0100"),
+        files{0x01, 0x02, 0x03, 0xFF},
+        cache(dir) {
+    control_infos[Option::GAIN] = {0, 48, 24};
+    control_infos[Option::BRIGHTNESS] = {-255, 240, 192};
+  }
+
+  ~InfoCacheTest() {
+    std::remove(path.c_str());
+    std::remove(dir.c_str());
+  }
+
+  std::string dir;
+  std::string path;
+  std::string key;
+  InfoCache::bytes_t files;
+  InfoCache::control_infos_t control_infos;
+  InfoCache cache;
+};
+
+TEST_F(InfoCacheTest, RoundTrip) {
+  InfoCache::bytes_t loaded_files;
+  InfoCache::control_infos_t loaded_infos;
+  EXPECT_FALSE(cache.Load(key, &loaded_files, &loaded_infos));
+
+  // nothing to save until the files are set
+  EXPECT_FALSE(cache.Save(control_infos));
+  cache.SetFiles(key, files);
+  EXPECT_TRUE(cache.Save(control_infos));
+  EXPECT_FALSE(cache.Save(control_infos));
+
+  InfoCache other(dir);
+  ASSERT_TRUE(other.Load(key, &loaded_files, &loaded_infos));
+  EXPECT_EQ(files, loaded_files);
+  ASSERT_EQ(2u, loaded_infos.size());
+  auto &&gain = loaded_infos[Option::GAIN];
+  EXPECT_EQ(0, gain.min);
+  EXPECT_EQ(48, gain.max);
+  EXPECT_EQ(24, gain.def);
+  auto &&brightness = loaded_infos[Option::BRIGHTNESS];
+  EXPECT_EQ(-255, brightness.min);
+  EXPECT_EQ(240, brightness.max);
+  EXPECT_EQ(192, brightness.def);
+}
+
+TEST_F(InfoCacheTest, OtherKey) {
+  cache.SetFiles(key, files);
+  ASSERT_TRUE(cache.Save(control_infos));
+
+  InfoCache::bytes_t loaded_files;
+  InfoCache::control_infos_t loaded_infos;
+  // the same file name, but not the same key
+  EXPECT_FALSE(cache.Load("usb-0123_0100", &loaded_files, &loaded_infos));
+  EXPECT_TRUE(loaded_files.empty());
+  EXPECT_TRUE(loaded_infos.empty());
+}
+
+TEST_F(InfoCacheTest, Broken) {
+  cache.SetFiles(key, files);
+  ASSERT_TRUE(cache.Save(control_infos));
+
+  InfoCache::bytes_t data;
+  {
+    std::ifstream ifs(path, std::ios::binary);
+    ASSERT_TRUE(ifs.is_open());
+    data.assign(std::istreambuf_iterator<char>(ifs),
+        std::istreambuf_iterator<char>());
+  }
+  ASSERT_GT(data.size(), 10u);
+
+  InfoCache::bytes_t loaded_files;
+  InfoCache::control_infos_t loaded_infos;
+  // a byte changed
+  data[10] ^= 0x01;
+  {
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs.write(reinterpret_cast<const char *>(data.data()), data.size());
+  }
+  EXPECT_FALSE(cache.Load(key, &loaded_files, &loaded_infos));
+
+  // truncated
+  {
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs.write(reinterpret_cast<const char *>(data.data()), 3);
+  }
+  EXPECT_FALSE(cache.Load(key, &loaded_files, &loaded_infos));
+  EXPECT_TRUE(loaded_files.empty());
+}
+
+TEST_F(InfoCacheTest, Invalidate) {
+  cache.SetFiles(key, files);
+  cache.Invalidate();
+  // the files set are dropped
+  EXPECT_FALSE(cache.Save(control_infos));
+
+  cache.SetFiles(key, files);
+  ASSERT_TRUE(cache.Save(control_infos));
+  cache.Invalidate();
+  EXPECT_FALSE(std::ifstream(path).is_open());
+
+  InfoCache::bytes_t loaded_files;
+  InfoCache::control_infos_t loaded_infos;
+  EXPECT_FALSE(cache.Load(key, &loaded_files, &loaded_infos));
+}
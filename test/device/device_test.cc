@@ -0,0 +1,102 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <limits>
+
+#include "mynteye/device/context.h"
+#include "mynteye/device/device.h"
+#include "mynteye/device/channel/info_cache.h"
+
+#include "device/replay.h"
+
+MYNTEYE_USE_NAMESPACE
+
+// Devices are replayed by the v4l2 backend only
+#ifdef MYNTEYE_OS_LINUX
+
+class DeviceTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    test::write_replay_device(dir, {0x07});
+    setenv("MYNTEYE_UVC_REPLAY", dir.c_str(), 1);
+  }
+
+  void TearDown() override {
+    unsetenv("MYNTEYE_UVC_REPLAY");
+    test::remove_replay_device(dir);
+  }
+
+  std::string dir = "device_test";
+};
+
+TEST_F(DeviceTest, EnableMotionDatas) {
+  Context context;
+  ASSERT_EQ(1u, context.descs().size());
+  auto &&device = context.Open(0);
+  ASSERT_NE(nullptr, device);
+
+  // the default max size is unbounded, and is limited as preallocated
+  device->EnableMotionDatas();
+  device->EnableMotionDatas(std::numeric_limits<std::size_t>::max());
+  device->EnableMotionDatas(100);
+
+  device->Start(Source::MOTION_TRACKING);
+  EXPECT_TRUE(device->GetMotionDatas().empty());
+  device->Stop(Source::MOTION_TRACKING);
+}
+
+TEST_F(DeviceTest, InfoCache) {
+  std::string cache_dir = "device_test_cache";
+  setenv("MYNTEYE_CACHE_DIR", cache_dir.c_str(), 1);
+  auto &&open = []() {
+    Context context;
+    return context.Open(0);
+  };
+
+  test::write_replay_device(dir, {0x07, 0x01});
+  auto &&device = open();
+  ASSERT_NE(nullptr, device);
+  EXPECT_EQ(1, device->GetInfo()->hardware_version.major());
+  // wait the option ranges, then the files are cached with them
+  device->GetOptionInfo(Option::GAIN);
+  auto &&key = device->GetInfo()->serial_number + "_" +
+      device->GetInfo()->firmware_version.to_string();
+  device = nullptr;
+
+  // the device info only is read, as the files would fail
+  test::write_replay_device(dir, {0x01});
+  device = open();
+  ASSERT_NE(nullptr, device);
+  EXPECT_EQ(1, device->GetInfo()->hardware_version.major());
+  device = nullptr;
+
+  // the device info changed, the files are read again
+  test::write_replay_device(dir, {0x07, 0x01}, 2);
+  device = open();
+  ASSERT_NE(nullptr, device);
+  EXPECT_EQ(2, device->GetInfo()->hardware_version.major());
+  device = nullptr;
+
+  unsetenv("MYNTEYE_CACHE_DIR");
+  InfoCache cache(cache_dir);
+  InfoCache::bytes_t files;
+  InfoCache::control_infos_t control_infos;
+  EXPECT_TRUE(cache.Load(key, &files, &control_infos));
+  cache.Invalidate();
+  std::remove(cache_dir.c_str());
+}
+
+#endif  // MYNTEYE_OS_LINUX
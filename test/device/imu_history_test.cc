@@ -0,0 +1,144 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "gtest/gtest.h"
+
+#include <limits>
+
+#include "mynteye/device/imu_history.h"
+
+MYNTEYE_USE_NAMESPACE
+
+namespace {
+
+// Push a sample whose accel is value and gyro is value * 10, of the flag
+void push(device::MotionBatch *batch, std::uint8_t flag,
+    std::uint64_t timestamp, float value) {
+  std::size_t i = batch->size();
+  batch->resize(i + 1);
+  batch->frame_id[i] = i;
+  batch->flag[i] = flag;
+  batch->timestamp[i] = timestamp;
+  batch->temperature[i] = 25;
+  for (int j = 0; j < 3; j++) {
+    batch->accel[j][i] = flag == 2 ? 0 : value;
+    batch->gyro[j][i] = flag == 1 ? 0 : value * 10;
+  }
+}
+
+// Samples of flag 0 at 1000, 2000, ..., whose values are 1, 2, ...
+device::MotionBatch make_batch(std::size_t n) {
+  device::MotionBatch batch;
+  for (std::size_t i = 1; i <= n; i++) {
+    push(&batch, 0, i * 1000, i);
+  }
+  return batch;
+}
+
+}  // namespace
+
+TEST(ImuHistory, Capacity) {
+  EXPECT_EQ(1u, ImuHistory(0).capacity());
+  EXPECT_EQ(1u, ImuHistory(1).capacity());
+  EXPECT_EQ(8u, ImuHistory(5).capacity());
+  EXPECT_EQ(8u, ImuHistory(8).capacity());
+}
+
+TEST(ImuHistory, Empty) {
+  ImuHistory history(8);
+  EXPECT_TRUE(history.GetRange(0, 10000).empty());
+  ImuData imu;
+  EXPECT_FALSE(history.Interpolate(1000, &imu));
+}
+
+TEST(ImuHistory, GetRange) {
+  ImuHistory history(8);
+  history.Push(make_batch(5));
+
+  // inclusive
+  auto &&datas = history.GetRange(2000, 4000);
+  ASSERT_EQ(3u, datas.size());
+  for (std::size_t i = 0; i < 3; i++) {
+    EXPECT_EQ((i + 2) * 1000, datas[i].timestamp);
+    EXPECT_DOUBLE_EQ(i + 2, datas[i].accel[0]);
+    EXPECT_DOUBLE_EQ((i + 2) * 10, datas[i].gyro[0]);
+  }
+  EXPECT_EQ(2u, history.GetRange(1500, 3500).size());
+  EXPECT_EQ(5u, history.GetRange(0, 10000).size());
+  EXPECT_EQ(5u,
+      history.GetRange(0, std::numeric_limits<std::uint64_t>::max()).size());
+  EXPECT_TRUE(history.GetRange(6000, 10000).empty());
+  EXPECT_TRUE(history.GetRange(4000, 3000).empty());
+}
+
+TEST(ImuHistory, Overwrite) {
+  ImuHistory history(4);
+  history.Push(make_batch(3));
+  history.Push(make_batch(6));
+  auto &&datas = history.GetRange(0, 10000);
+  // the last 4 pushed
+  ASSERT_EQ(4u, datas.size());
+  EXPECT_EQ(3000u, datas.front().timestamp);
+  EXPECT_EQ(6000u, datas.back().timestamp);
+
+  // a batch more than the capacity keeps its last ones
+  history.Push(make_batch(10));
+  datas = history.GetRange(0, 20000);
+  ASSERT_EQ(4u, datas.size());
+  EXPECT_EQ(7000u, datas.front().timestamp);
+  EXPECT_EQ(10000u, datas.back().timestamp);
+}
+
+TEST(ImuHistory, Interpolate) {
+  ImuHistory history(8);
+  history.Push(make_batch(3));
+
+  ImuData imu;
+  ASSERT_TRUE(history.Interpolate(1500, &imu));
+  EXPECT_EQ(1500u, imu.timestamp);
+  EXPECT_EQ(0, imu.flag);
+  EXPECT_DOUBLE_EQ(1.5, imu.accel[0]);
+  EXPECT_DOUBLE_EQ(15, imu.gyro[2]);
+  EXPECT_DOUBLE_EQ(25, imu.temperature);
+
+  // at the ends
+  ASSERT_TRUE(history.Interpolate(1000, &imu));
+  EXPECT_DOUBLE_EQ(1, imu.accel[1]);
+  ASSERT_TRUE(history.Interpolate(3000, &imu));
+  EXPECT_DOUBLE_EQ(30, imu.gyro[1]);
+
+  // out of the history
+  EXPECT_FALSE(history.Interpolate(999, &imu));
+  EXPECT_FALSE(history.Interpolate(3001, &imu));
+}
+
+TEST(ImuHistory, InterpolateEachValid) {
+  ImuHistory history(8);
+  device::MotionBatch batch;
+  push(&batch, 1, 1000, 1);
+  push(&batch, 2, 1200, 2);
+  push(&batch, 2, 1800, 4);
+  push(&batch, 1, 2000, 3);
+  history.Push(batch);
+
+  ImuData imu;
+  // accel between 1000 and 2000, gyro between 1200 and 1800
+  ASSERT_TRUE(history.Interpolate(1500, &imu));
+  EXPECT_DOUBLE_EQ(2, imu.accel[0]);
+  EXPECT_DOUBLE_EQ(30, imu.gyro[0]);
+
+  // no gyro before
+  EXPECT_FALSE(history.Interpolate(1100, &imu));
+  // no gyro after
+  EXPECT_FALSE(history.Interpolate(1900, &imu));
+}
@@ -0,0 +1,135 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "gtest/gtest.h"
+
+#include "mynteye/device/motion_merger.h"
+
+MYNTEYE_USE_NAMESPACE
+
+namespace {
+
+// Push a sample whose values are all the value, of the flag
+void push(device::MotionBatch *batch, std::uint8_t flag,
+    std::uint64_t timestamp, float value) {
+  std::size_t i = batch->size();
+  batch->resize(i + 1);
+  batch->frame_id[i] = i;
+  batch->flag[i] = flag;
+  batch->timestamp[i] = timestamp;
+  batch->temperature[i] = 25;
+  for (int j = 0; j < 3; j++) {
+    batch->accel[j][i] = flag == 2 ? 0 : value;
+    batch->gyro[j][i] = flag == 1 ? 0 : value;
+  }
+}
+
+}  // namespace
+
+TEST(MotionMerger, PassBoth) {
+  device::MotionBatch src, dst;
+  push(&src, 0, 1000, 1);
+  push(&src, 0, 2000, 2);
+
+  MotionMerger merger;
+  merger.Merge(src, &dst);
+  ASSERT_EQ(2u, dst.size());
+  EXPECT_FALSE(dst.calibrated());
+  for (std::size_t i = 0; i < 2; i++) {
+    EXPECT_EQ(0, dst.flag[i]);
+    EXPECT_EQ(src.timestamp[i], dst.timestamp[i]);
+    EXPECT_EQ(src.frame_id[i], dst.frame_id[i]);
+    EXPECT_FLOAT_EQ(25, dst.temperature[i]);
+    for (int j = 0; j < 3; j++) {
+      EXPECT_FLOAT_EQ(src.accel[j][i], dst.accel[j][i]);
+      EXPECT_FLOAT_EQ(src.gyro[j][i], dst.gyro[j][i]);
+    }
+  }
+}
+
+TEST(MotionMerger, Interpolate) {
+  device::MotionBatch src, dst;
+  push(&src, 1, 1000, 1);
+  push(&src, 2, 1000, 5);  // at the accel, merged at once
+  push(&src, 2, 1250, 6);
+  push(&src, 2, 1750, 7);
+  push(&src, 1, 2000, 3);
+
+  MotionMerger merger;
+  merger.Merge(src, &dst);
+  ASSERT_EQ(3u, dst.size());
+  const std::uint64_t timestamps[3] = {1000, 1250, 1750};
+  const float accels[3] = {1, 1.5f, 2.5f};
+  const float gyros[3] = {5, 6, 7};
+  for (std::size_t i = 0; i < 3; i++) {
+    EXPECT_EQ(0, dst.flag[i]);
+    EXPECT_EQ(timestamps[i], dst.timestamp[i]);
+    for (int j = 0; j < 3; j++) {
+      EXPECT_FLOAT_EQ(accels[i], dst.accel[j][i]);
+      EXPECT_FLOAT_EQ(gyros[i], dst.gyro[j][i]);
+    }
+  }
+}
+
+TEST(MotionMerger, PendingAcrossBatches) {
+  MotionMerger merger;
+  device::MotionBatch src, dst;
+  push(&src, 1, 1000, 0);
+  push(&src, 2, 1500, 4);
+  merger.Merge(src, &dst);
+  // the gyro waits for the next accel
+  EXPECT_EQ(0u, dst.size());
+
+  src = {};
+  push(&src, 1, 3000, 6);
+  merger.Merge(src, &dst);
+  ASSERT_EQ(1u, dst.size());
+  EXPECT_EQ(1500u, dst.timestamp[0]);
+  EXPECT_FLOAT_EQ(1.5f, dst.accel[0][0]);
+  EXPECT_FLOAT_EQ(4, dst.gyro[0][0]);
+}
+
+TEST(MotionMerger, DropGyrosBeforeAccel) {
+  MotionMerger merger;
+  device::MotionBatch src, dst;
+  push(&src, 2, 500, 4);
+  push(&src, 1, 1000, 1);
+  push(&src, 2, 1500, 5);
+  push(&src, 1, 2000, 3);
+  merger.Merge(src, &dst);
+  // no accel to interpolate the first gyro
+  ASSERT_EQ(1u, dst.size());
+  EXPECT_EQ(1500u, dst.timestamp[0]);
+  EXPECT_FLOAT_EQ(2, dst.accel[1][0]);
+}
+
+TEST(MotionMerger, Calibrated) {
+  device::MotionBatch src, dst;
+  push(&src, 1, 1000, 1);
+  push(&src, 2, 1500, 5);
+  push(&src, 1, 2000, 3);
+  src.resize(src.size(), true);
+  for (std::size_t i = 0; i < src.size(); i++) {
+    for (int j = 0; j < 3; j++) {
+      src.accel_calibrated[j][i] = src.accel[j][i] * 10;
+      src.gyro_calibrated[j][i] = src.gyro[j][i] * 10;
+    }
+  }
+
+  MotionMerger merger;
+  merger.Merge(src, &dst);
+  ASSERT_EQ(1u, dst.size());
+  ASSERT_TRUE(dst.calibrated());
+  EXPECT_FLOAT_EQ(20, dst.accel_calibrated[2][0]);
+  EXPECT_FLOAT_EQ(50, dst.gyro_calibrated[2][0]);
+}
@@ -0,0 +1,145 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "mynteye/device/preintegrator.h"
+
+MYNTEYE_USE_NAMESPACE
+
+namespace {
+
+// Samples of flag 0 every step from begin to end, with the same values
+device::MotionBatch make_batch(std::uint64_t begin, std::uint64_t end,
+    std::uint64_t step, const float accel[3], const float gyro[3]) {
+  device::MotionBatch batch;
+  batch.resize((end - begin) / step + 1);
+  for (std::size_t i = 0; i < batch.size(); i++) {
+    batch.frame_id[i] = i;
+    batch.flag[i] = 0;
+    batch.timestamp[i] = begin + i * step;
+    for (int j = 0; j < 3; j++) {
+      batch.accel[j][i] = accel[j];
+      batch.gyro[j][i] = gyro[j];
+    }
+  }
+  return batch;
+}
+
+}  // namespace
+
+class PreintegratorTest : public ::testing::Test {
+ protected:
+  PreintegratorTest()
+      : preintegrator([this](const device::ImuPreintegration &p) {
+          results.push_back(p);
+        }) {}
+
+  std::vector<device::ImuPreintegration> results;
+  Preintegrator preintegrator;
+};
+
+TEST_F(PreintegratorTest, Accel) {
+  const float accel[3] = {1, 0, 0};
+  const float gyro[3] = {0, 0, 0};
+  preintegrator.PushFrame(1, 1000);
+  preintegrator.PushFrame(2, 3000);
+  // the last sample is at the frame, all samples are integrated
+  preintegrator.Integrate(make_batch(1000, 3000, 100, accel, gyro));
+
+  // the first frame only starts
+  ASSERT_EQ(1u, results.size());
+  auto &&p = results[0];
+  EXPECT_EQ(2, p.frame_id);
+  EXPECT_EQ(1000u, p.begin_timestamp);
+  EXPECT_EQ(3000u, p.end_timestamp);
+  EXPECT_EQ(20u, p.count);
+
+  double t = 0.002;
+  EXPECT_NEAR(9.80665 * t, p.delta_velocity[0], 1e-9);
+  EXPECT_NEAR(0.5 * 9.80665 * t * t, p.delta_position[0], 1e-12);
+  for (int i = 1; i < 3; i++) {
+    EXPECT_DOUBLE_EQ(0, p.delta_velocity[i]);
+    EXPECT_DOUBLE_EQ(0, p.delta_position[i]);
+  }
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      EXPECT_DOUBLE_EQ(i == j ? 1 : 0, p.delta_rotation[i][j]);
+    }
+  }
+}
+
+TEST_F(PreintegratorTest, Gyro) {
+  const float accel[3] = {0, 0, 0};
+  const float gyro[3] = {0, 0, 90};
+  preintegrator.PushFrame(1, 1000000);
+  preintegrator.PushFrame(2, 2000000);
+  preintegrator.Integrate(make_batch(1000000, 2000000, 10000, accel, gyro));
+
+  // 90 degrees around z in 1s
+  ASSERT_EQ(1u, results.size());
+  const double r[3][3] = {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}};
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      EXPECT_NEAR(r[i][j], results[0].delta_rotation[i][j], 1e-6);
+    }
+  }
+}
+
+TEST_F(PreintegratorTest, HoldSamplesUntilFrames) {
+  const float accel[3] = {0, 0, 1};
+  const float gyro[3] = {0, 0, 0};
+  preintegrator.PushFrame(1, 1000);
+  preintegrator.Integrate(make_batch(1000, 2000, 100, accel, gyro));
+  EXPECT_TRUE(results.empty());
+
+  // frames come later than the samples of their time
+  preintegrator.PushFrame(2, 1500);
+  preintegrator.PushFrame(3, 2500);
+  preintegrator.Integrate(device::MotionBatch());
+  ASSERT_EQ(1u, results.size());
+  EXPECT_EQ(2, results[0].frame_id);
+  EXPECT_EQ(5u, results[0].count);
+
+  preintegrator.Integrate(make_batch(2100, 2500, 100, accel, gyro));
+  ASSERT_EQ(2u, results.size());
+  EXPECT_EQ(3, results[1].frame_id);
+  EXPECT_EQ(1500u, results[1].begin_timestamp);
+  EXPECT_EQ(10u, results[1].count);
+  EXPECT_NEAR(9.80665 * 0.001, results[1].delta_velocity[2], 1e-9);
+}
+
+TEST_F(PreintegratorTest, NoSamples) {
+  preintegrator.PushFrame(1, 1000);
+  preintegrator.PushFrame(2, 2000);
+  preintegrator.Integrate(device::MotionBatch());
+  EXPECT_TRUE(results.empty());
+}
+
+TEST_F(PreintegratorTest, DropFramesNotReached) {
+  const float accel[3] = {0, 0, 0};
+  const float gyro[3] = {0, 0, 0};
+  preintegrator.PushFrame(1, 1000);
+  preintegrator.Integrate(make_batch(1000, 1000, 100, accel, gyro));
+  // the samples never reach it, such as of a wrapped timestamp
+  preintegrator.PushFrame(2, 0xFFFFFFFFFFull);
+  for (std::uint16_t i = 3; i < 200; i++) {
+    preintegrator.PushFrame(i, i * 1000);
+    preintegrator.Integrate(
+        make_batch(i * 1000 - 900, i * 1000, 100, accel, gyro));
+  }
+  ASSERT_FALSE(results.empty());
+  EXPECT_EQ(199, results.back().frame_id);
+}
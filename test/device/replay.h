@@ -0,0 +1,88 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef MYNTEYE_TEST_DEVICE_REPLAY_H_
+#define MYNTEYE_TEST_DEVICE_REPLAY_H_
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "mynteye/mynteye.h"
+#include "mynteye/device/channel/def.h"
+#include "mynteye/uvc/uvc.h"
+#include "mynteye/util/files.h"
+
+MYNTEYE_BEGIN_NAMESPACE
+
+namespace test {
+
+// Write a replay device of S1030 to dir, which answers the files queries of
+// the headers with the device info only, no frames or imu datas
+inline void write_replay_device(const std::string &dir,
+    const std::vector<std::uint8_t> &headers,
+    std::uint8_t hardware_major = 1) {
+  files::mkdir(dir);
+  std::ofstream(dir + MYNTEYE_OS_SEP + "device.txt")
+      << "name=MYNT-EYE-S1030" << std::endl
+      << "vid=1204" << std::endl
+      << "pid=249" << std::endl;
+
+  // vid, pid, name, serial_number, firmware, hardware, spec, lens, imu,
+  // nominal_baseline
+  std::vector<std::uint8_t> info(53, 0);
+  std::string name = "MYNT-EYE-S1030", serial = "0123456789";
+  std::copy(name.begin(), name.end(), info.begin() + 4);
+  std::copy(serial.begin(), serial.end(), info.begin() + 20);
+  info[36] = 2;  // firmware 2.0
+  info[38] = hardware_major;
+  info[41] = 1;  // spec 1.0
+  info[52] = 120;
+  std::vector<std::uint8_t> file{FID_DEVICE_INFO, 0,
+      static_cast<std::uint8_t>(info.size())};
+  file.insert(file.end(), info.begin(), info.end());
+
+  std::ofstream xu(dir + MYNTEYE_OS_SEP + "xu.bin", std::ios::binary);
+  for (auto &&header : headers) {
+    // selector, query, key, size in little endian, then the response
+    std::uint8_t head[5] = {CHANNEL_FILE, uvc::XU_QUERY_GET, header,
+        2000 & 0xFF, 2000 >> 8};
+    std::vector<std::uint8_t> data(2000, 0);
+    data[0] = header;
+    data[2] = static_cast<std::uint8_t>(file.size());
+    std::copy(file.begin(), file.end(), data.begin() + 3);
+    std::uint8_t checksum = 0;
+    for (auto &&b : file) {
+      checksum ^= b;
+    }
+    data[3 + file.size()] = checksum;
+    xu.write(reinterpret_cast<const char *>(head), 5);
+    xu.write(reinterpret_cast<const char *>(data.data()), data.size());
+  }
+}
+
+inline void remove_replay_device(const std::string &dir) {
+  for (auto &&name : {"device.txt", "xu.bin"}) {
+    std::remove((dir + MYNTEYE_OS_SEP + name).c_str());
+  }
+  std::remove(dir.c_str());
+}
+
+}  // namespace test
+
+MYNTEYE_END_NAMESPACE
+
+#endif  // MYNTEYE_TEST_DEVICE_REPLAY_H_
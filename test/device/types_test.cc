@@ -123,3 +123,59 @@ TEST_F(TypeTest, Strings) {
   EXPECT_EQ("012A", type_1_2a.to_string());
   EXPECT_EQ("010A", Type("010A").to_string());
 }
+
+TEST(CaptureStats, AccumulateEmpty) {
+  device::CaptureStats stats;
+  stats.frames_count = 2;
+  stats.first_time = 100;
+  stats.last_time = 200;
+
+  stats += device::CaptureStats();
+  EXPECT_EQ(2u, stats.frames_count);
+  EXPECT_EQ(100u, stats.first_time);
+  EXPECT_EQ(200u, stats.last_time);
+
+  device::CaptureStats empty;
+  empty += stats;
+  EXPECT_EQ(2u, empty.frames_count);
+  EXPECT_EQ(100u, empty.first_time);
+  EXPECT_EQ(200u, empty.last_time);
+}
+
+TEST(CaptureStats, Accumulate) {
+  device::CaptureStats a;
+  a.frames_count = 11;
+  a.sequence_gaps = 1;
+  a.first_time = 1000;
+  a.last_time = 2000;
+  a.latency_histogram[0] = 10;
+  a.latency_histogram[7] = 1;
+  a.latency_max = 300;
+  a.callback_time_max = 20;
+  a.frame_pool_hits = 5;
+
+  device::CaptureStats b;
+  b.frames_count = 21;
+  b.dropped_count = 2;
+  b.first_time = 500;
+  b.last_time = 1500;
+  b.latency_histogram[0] = 20;
+  b.latency_max = 100;
+  b.callback_time_max = 40;
+  b.frame_pool_misses = 3;
+
+  a += b;
+  EXPECT_EQ(32u, a.frames_count);
+  EXPECT_EQ(1u, a.sequence_gaps);
+  EXPECT_EQ(2u, a.dropped_count);
+  // the range of both
+  EXPECT_EQ(500u, a.first_time);
+  EXPECT_EQ(2000u, a.last_time);
+  EXPECT_EQ(30u, a.latency_histogram[0]);
+  EXPECT_EQ(1u, a.latency_histogram[7]);
+  EXPECT_EQ(300u, a.latency_max);
+  EXPECT_EQ(40u, a.callback_time_max);
+  EXPECT_EQ(5u, a.frame_pool_hits);
+  EXPECT_EQ(3u, a.frame_pool_misses);
+  EXPECT_DOUBLE_EQ(31 * 1000000.0 / 1500, a.fps());
+}
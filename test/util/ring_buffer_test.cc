@@ -0,0 +1,130 @@
+// Copyright 2018 Slightech Co., Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "mynteye/util/ring_buffer.h"
+
+MYNTEYE_USE_NAMESPACE
+
+TEST(RingBuffer, PushPop) {
+  RingBuffer<int> ring(3);
+  EXPECT_EQ(3u, ring.capacity());
+  EXPECT_TRUE(ring.empty());
+
+  int value = -1;
+  EXPECT_FALSE(ring.TryPop(&value));
+  EXPECT_EQ(-1, value);
+
+  EXPECT_TRUE(ring.TryPush(1));
+  EXPECT_TRUE(ring.TryPush(2));
+  EXPECT_TRUE(ring.TryPush(3));
+  EXPECT_FALSE(ring.TryPush(4));
+  EXPECT_EQ(3u, ring.size());
+
+  EXPECT_TRUE(ring.TryPop(&value));
+  EXPECT_EQ(1, value);
+  EXPECT_TRUE(ring.TryPush(4));
+  for (int i = 2; i <= 4; i++) {
+    EXPECT_TRUE(ring.TryPop(&value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_FALSE(ring.TryPop(&value));
+  EXPECT_TRUE(ring.empty());
+}
+
+TEST(RingBuffer, ZeroCapacity) {
+  RingBuffer<int> ring(0);
+  EXPECT_EQ(1u, ring.capacity());
+  EXPECT_TRUE(ring.TryPush(1));
+  EXPECT_FALSE(ring.TryPush(2));
+}
+
+TEST(RingBuffer, PushOverwrite) {
+  RingBuffer<int> ring(2);
+  EXPECT_EQ(0u, ring.PushOverwrite(1));
+  EXPECT_EQ(0u, ring.PushOverwrite(2));
+
+  int dropped = 0;
+  EXPECT_EQ(1u, ring.PushOverwrite(3, &dropped));
+  EXPECT_EQ(1, dropped);
+  EXPECT_EQ(1u, ring.PushOverwrite(4, &dropped));
+  EXPECT_EQ(2, dropped);
+
+  int value = 0;
+  EXPECT_TRUE(ring.TryPop(&value));
+  EXPECT_EQ(3, value);
+  EXPECT_TRUE(ring.TryPop(&value));
+  EXPECT_EQ(4, value);
+  EXPECT_TRUE(ring.empty());
+}
+
+TEST(RingBuffer, Clear) {
+  auto data = std::make_shared<int>(1);
+  RingBuffer<std::shared_ptr<int>> ring(4);
+  EXPECT_TRUE(ring.TryPush(data));
+  EXPECT_TRUE(ring.TryPush(data));
+  EXPECT_EQ(3, data.use_count());
+
+  ring.Clear();
+  EXPECT_TRUE(ring.empty());
+  // the popped ones are released
+  EXPECT_EQ(1, data.use_count());
+  EXPECT_TRUE(ring.TryPush(data));
+  EXPECT_EQ(1u, ring.size());
+}
+
+TEST(RingBuffer, Concurrent) {
+  const int producers = 4;
+  const int count = 10000;
+  RingBuffer<int> ring(16);
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&ring, p]() {
+      for (int i = 0; i < count; i++) {
+        while (!ring.TryPush(p * count + i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  std::vector<int> last(producers, -1);
+  std::vector<int> popped(producers, 0);
+  for (int n = 0; n < producers * count;) {
+    int value;
+    if (!ring.TryPop(&value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    int p = value / count;
+    int i = value % count;
+    // in order of each producer
+    EXPECT_GT(i, last[p]);
+    last[p] = i;
+    ++popped[p];
+    ++n;
+  }
+  for (auto &&t : threads) {
+    t.join();
+  }
+  for (int p = 0; p < producers; p++) {
+    EXPECT_EQ(count, popped[p]);
+  }
+  EXPECT_TRUE(ring.empty());
+}
@@ -68,23 +68,23 @@ void Dataset::SaveStreamData(
     if (data.frame->format() == Format::GREY) {
       cv::Mat img(
           data.frame->height(), data.frame->width(), CV_8UC1,
-          data.frame->data());
+          data.frame->data(), data.frame->step());
       cv::imwrite(ss.str(), img);
     } else if (data.frame->format() == Format::YUYV) {
+      auto &&bgr = data.frame->bgr();
       cv::Mat img(
-          data.frame->height(), data.frame->width(), CV_8UC2,
-          data.frame->data());
-      cv::cvtColor(img, img, cv::COLOR_YUV2BGR_YUY2);
+          bgr->height(), bgr->width(), CV_8UC3,
+          const_cast<std::uint8_t *>(bgr->data()), bgr->step());
       cv::imwrite(ss.str(), img);
     } else if (data.frame->format() == Format::BGR888) {
       cv::Mat img(
           data.frame->height(), data.frame->width(), CV_8UC3,
-          data.frame->data());
+          data.frame->data(), data.frame->step());
       cv::imwrite(ss.str(), img);
     } else {
       cv::Mat img(
           data.frame->height(), data.frame->width(), CV_8UC1,
-          data.frame->data());
+          data.frame->data(), data.frame->step());
       cv::imwrite(ss.str(), img);
     }
   }
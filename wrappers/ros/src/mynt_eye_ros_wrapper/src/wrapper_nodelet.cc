@@ -1072,37 +1072,36 @@ class ROSWrapperNodelet : public nodelet::Nodelet {
     NODELET_INFO_STREAM("Detecting MYNT EYE devices");
 
     Context context;
-    auto &&devices = context.devices();
+    auto &&descs = context.descs();
 
-    size_t n = devices.size();
+    size_t n = descs.size();
     NODELET_FATAL_COND(n <= 0, "No MYNT EYE devices :(");
 
     NODELET_INFO_STREAM("MYNT EYE devices:");
     for (size_t i = 0; i < n; i++) {
-      auto &&device = devices[i];
-      auto &&name = device->GetInfo(Info::DEVICE_NAME);
-      NODELET_INFO_STREAM("  index: " << i << ", name: " << name);
+      NODELET_INFO_STREAM("  index: " << i << ", name: " << descs[i].name
+          << ", bus: " << descs[i].bus_path);
     }
 
-    std::shared_ptr<Device> device = nullptr;
+    size_t index = 0;
     if (n <= 1) {
-      device = devices[0];
       NODELET_INFO_STREAM("Only one MYNT EYE device, select index: 0");
     } else {
       while (true) {
-        size_t i;
         NODELET_INFO_STREAM(
             "There are " << n << " MYNT EYE devices, select index: ");
-        std::cin >> i;
-        if (i >= n) {
+        std::cin >> index;
+        if (index >= n) {
           NODELET_WARN_STREAM("Index out of range :(");
           continue;
         }
-        device = devices[i];
         break;
       }
     }
 
+    std::shared_ptr<Device> device = context.Open(index);
+    NODELET_FATAL_COND(!device, "Failed to open MYNT EYE device :(");
+
     api_ = API::Create(device);
     auto &&requests = device->GetStreamRequests();
     std::size_t m = requests.size();